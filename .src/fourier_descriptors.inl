@@ -0,0 +1,205 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace crisp
+{
+    inline FourierDescriptorEngine::FourierDescriptorEngine(size_t n_samples, size_t n_descriptors, ShapeSignature signature)
+        : _n_samples(n_samples), _n_descriptors(n_descriptors), _signature(signature)
+    {
+        assert(n_samples > 2);
+        assert(signature == ShapeSignature::COMPLEX_COORDINATE ? n_descriptors <= n_samples - 2 : n_descriptors <= n_samples / 2);
+
+        _plan = FourierPlanCache::get().get_dft_1d_batch<float>(_n_samples, _batch_size, FFTW_FORWARD);
+    }
+
+    inline size_t FourierDescriptorEngine::get_n_samples() const
+    {
+        return _n_samples;
+    }
+
+    inline size_t FourierDescriptorEngine::get_n_descriptors() const
+    {
+        return _n_descriptors;
+    }
+
+    inline ShapeSignature FourierDescriptorEngine::get_signature() const
+    {
+        return _signature;
+    }
+
+    inline Eigen::MatrixXf FourierDescriptorEngine::compute(const std::vector<std::vector<Vector2ui>>& boundaries) const
+    {
+        return compute_from(boundaries.size(), [&](size_t i) -> const std::vector<Vector2ui>& {
+            return boundaries[i];
+        });
+    }
+
+    inline Eigen::MatrixXf FourierDescriptorEngine::compute(const std::vector<Contour>& contours) const
+    {
+        return compute_from(contours.size(), [&](size_t i) {
+            return contours[i].to_points();
+        });
+    }
+
+    template<typename Image_t>
+    Eigen::MatrixXf FourierDescriptorEngine::compute(const std::vector<ImageRegion<Image_t>>& regions) const
+    {
+        return compute_from(regions.size(), [&](size_t i) -> const std::vector<Vector2ui>& {
+            return regions[i].get_boundary();
+        });
+    }
+
+    template<typename Function_t>
+    Eigen::MatrixXf FourierDescriptorEngine::compute_from(size_t n_boundaries, Function_t&& get_points) const
+    {
+        Eigen::MatrixXf out = Eigen::MatrixXf::Zero(_n_descriptors, n_boundaries);
+        size_t n_batches = (n_boundaries + _batch_size - 1) / _batch_size;
+
+        // each batch fills its own columns, executing a plan on new arrays is thread-safe
+        ThreadPool::get().parallel_for(n_batches, [&](size_t batch_i)
+        {
+            size_t first = batch_i * _batch_size;
+            size_t n = std::min(_batch_size, n_boundaries - first);
+
+            auto* buffer = fftwf_alloc_complex(_batch_size * _n_samples);
+
+            for (size_t i = 0; i < n; ++i)
+                fill_signature(get_points(first + i), buffer + i * _n_samples);
+
+            // the plan always transforms a full batch, pad the last one
+            auto* values = reinterpret_cast<float*>(buffer);
+            std::fill(values + 2 * n * _n_samples, values + 2 * _batch_size * _n_samples, 0.f);
+
+            fftwf_execute_dft(_plan.get(), buffer, buffer);
+
+            for (size_t i = 0; i < n; ++i)
+                fill_descriptors(buffer + i * _n_samples, out.data() + (first + i) * _n_descriptors);
+
+            fftwf_free(buffer);
+        });
+
+        return out;
+    }
+
+    inline void FourierDescriptorEngine::fill_signature(const std::vector<Vector2ui>& points, fftwf_complex* out) const
+    {
+        const size_t n = _n_samples;
+        std::vector<std::complex<float>> samples(n, std::complex<float>(0, 0));
+
+        if (not points.empty())
+        {
+            // resample the closed curve to n points equidistant in arc length
+            std::vector<float> lengths;
+            lengths.reserve(points.size());
+
+            float total = 0;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const auto& a = points[i];
+                const auto& b = points[(i + 1) % points.size()];
+                lengths.push_back(std::hypot(float(b.x()) - float(a.x()), float(b.y()) - float(a.y())));
+                total += lengths.back();
+            }
+
+            size_t segment_i = 0;
+            float segment_begin = 0;
+            for (size_t k = 0; k < n; ++k)
+            {
+                float s = k * total / n;
+                while (segment_i + 1 < points.size() and segment_begin + lengths[segment_i] < s)
+                    segment_begin += lengths[segment_i++];
+
+                const auto& a = points[segment_i];
+                const auto& b = points[(segment_i + 1) % points.size()];
+                float t = lengths[segment_i] > 0 ? std::clamp((s - segment_begin) / lengths[segment_i], 0.f, 1.f) : 0.f;
+
+                samples[k] = std::complex<float>(
+                    float(a.x()) + t * (float(b.x()) - float(a.x())),
+                    float(a.y()) + t * (float(b.y()) - float(a.y()))
+                );
+            }
+        }
+
+        if (_signature == ShapeSignature::COMPLEX_COORDINATE)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                out[k][0] = samples[k].real();
+                out[k][1] = samples[k].imag();
+            }
+        }
+        else if (_signature == ShapeSignature::RADIAL_DISTANCE)
+        {
+            std::complex<float> centroid(0, 0);
+            for (const auto& z : samples)
+                centroid += z;
+
+            centroid /= float(n);
+
+            for (size_t k = 0; k < n; ++k)
+            {
+                out[k][0] = std::abs(samples[k] - centroid);
+                out[k][1] = 0;
+            }
+        }
+        else if (_signature == ShapeSignature::FARTHEST_POINT)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                float max = 0;
+                for (size_t j = 0; j < n; ++j)
+                    max = std::max(max, std::norm(samples[k] - samples[j]));
+
+                out[k][0] = std::sqrt(max);
+                out[k][1] = 0;
+            }
+        }
+    }
+
+    inline void FourierDescriptorEngine::fill_descriptors(const fftwf_complex* spectrum, float* out) const
+    {
+        const size_t n = _n_samples;
+        auto magnitude = [&](long k) -> float {
+            size_t i = ((k % long(n)) + n) % n;
+            return std::hypot(spectrum[i][0], spectrum[i][1]);
+        };
+
+        if (_signature == ShapeSignature::COMPLEX_COORDINATE)
+        {
+            // F(0) only holds the translation. Depending on the direction the curve is traversed in, either F(1) or F(-1)
+            // dominates, normalize by it and mirror the frequencies so both directions result in the same descriptors
+            float positive = magnitude(1), negative = magnitude(-1);
+            float reference = std::max(positive, negative);
+            long sign = negative > positive ? -1 : 1;
+
+            if (reference == 0)
+                return;
+
+            // order by absolute frequency: -1, 2, -2, 3, -3, ...
+            for (size_t i = 0; i < _n_descriptors; ++i)
+            {
+                long k = i % 2 == 0 ? -long(i / 2 + 1) : long(i / 2 + 2);
+                out[i] = magnitude(sign * k) / reference;
+            }
+        }
+        else
+        {
+            // signature is real, so the spectrum is symmetric and F(0) is its mean
+            float reference = magnitude(0);
+
+            if (reference == 0)
+                return;
+
+            for (size_t i = 0; i < _n_descriptors; ++i)
+                out[i] = magnitude(i + 1) / reference;
+        }
+    }
+}
@@ -0,0 +1,333 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#include <resource_path.hpp>
+
+namespace crisp
+{
+    namespace detail
+    {
+        template<>
+        struct FFTW<float>
+        {
+            using Plan_t = fftwf_plan;
+            using Complex_t = fftwf_complex;
+
+            static constexpr int precision = 0;
+            static constexpr const char* wisdom_suffix = ".fftw3f";
+
+            static Complex_t* alloc_complex(size_t n) { return fftwf_alloc_complex(n); }
+            static float* alloc_real(size_t n) { return fftwf_alloc_real(n); }
+            static void free(void* data) { fftwf_free(data); }
+            static void destroy_plan(Plan_t plan) { fftwf_destroy_plan(plan); }
+            static void execute_r2c(Plan_t plan, float* in, Complex_t* out) { fftwf_execute_dft_r2c(plan, in, out); }
+            static void execute_c2r(Plan_t plan, Complex_t* in, float* out) { fftwf_execute_dft_c2r(plan, in, out); }
+
+            static Plan_t plan_dft_2d(int m, int n, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftwf_plan_dft_2d(m, n, data, data, direction, flags);
+            }
+
+            static Plan_t plan_dft_1d_batch(int n, int n_signals, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftwf_plan_many_dft(1, &n, n_signals, data, nullptr, 1, n, data, nullptr, 1, n, direction, flags);
+            }
+
+            static Plan_t plan_dft_r2c_1d(int n, float* in, Complex_t* out, unsigned flags)
+            {
+                return fftwf_plan_dft_r2c_1d(n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_r2c_2d(int m, int n, float* in, Complex_t* out, unsigned flags)
+            {
+                return fftwf_plan_dft_r2c_2d(m, n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_c2r_2d(int m, int n, Complex_t* in, float* out, unsigned flags)
+            {
+                return fftwf_plan_dft_c2r_2d(m, n, in, out, flags);
+            }
+
+            static bool import_wisdom(const std::string& path) { return fftwf_import_wisdom_from_filename(path.c_str()) != 0; }
+            static bool export_wisdom(const std::string& path) { return fftwf_export_wisdom_to_filename(path.c_str()) != 0; }
+        };
+
+        template<>
+        struct FFTW<double>
+        {
+            using Plan_t = fftw_plan;
+            using Complex_t = fftw_complex;
+
+            static constexpr int precision = 1;
+            static constexpr const char* wisdom_suffix = ".fftw3";
+
+            static Complex_t* alloc_complex(size_t n) { return fftw_alloc_complex(n); }
+            static double* alloc_real(size_t n) { return fftw_alloc_real(n); }
+            static void free(void* data) { fftw_free(data); }
+            static void destroy_plan(Plan_t plan) { fftw_destroy_plan(plan); }
+            static void execute_r2c(Plan_t plan, double* in, Complex_t* out) { fftw_execute_dft_r2c(plan, in, out); }
+            static void execute_c2r(Plan_t plan, Complex_t* in, double* out) { fftw_execute_dft_c2r(plan, in, out); }
+
+            static Plan_t plan_dft_2d(int m, int n, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftw_plan_dft_2d(m, n, data, data, direction, flags);
+            }
+
+            static Plan_t plan_dft_1d_batch(int n, int n_signals, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftw_plan_many_dft(1, &n, n_signals, data, nullptr, 1, n, data, nullptr, 1, n, direction, flags);
+            }
+
+            static Plan_t plan_dft_r2c_1d(int n, double* in, Complex_t* out, unsigned flags)
+            {
+                return fftw_plan_dft_r2c_1d(n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_r2c_2d(int m, int n, double* in, Complex_t* out, unsigned flags)
+            {
+                return fftw_plan_dft_r2c_2d(m, n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_c2r_2d(int m, int n, Complex_t* in, double* out, unsigned flags)
+            {
+                return fftw_plan_dft_c2r_2d(m, n, in, out, flags);
+            }
+
+            static bool import_wisdom(const std::string& path) { return fftw_import_wisdom_from_filename(path.c_str()) != 0; }
+            static bool export_wisdom(const std::string& path) { return fftw_export_wisdom_to_filename(path.c_str()) != 0; }
+        };
+
+        template<>
+        struct FFTW<long double>
+        {
+            using Plan_t = fftwl_plan;
+            using Complex_t = fftwl_complex;
+
+            static constexpr int precision = 2;
+            static constexpr const char* wisdom_suffix = ".fftw3l";
+
+            static Complex_t* alloc_complex(size_t n) { return fftwl_alloc_complex(n); }
+            static long double* alloc_real(size_t n) { return fftwl_alloc_real(n); }
+            static void free(void* data) { fftwl_free(data); }
+            static void destroy_plan(Plan_t plan) { fftwl_destroy_plan(plan); }
+            static void execute_r2c(Plan_t plan, long double* in, Complex_t* out) { fftwl_execute_dft_r2c(plan, in, out); }
+            static void execute_c2r(Plan_t plan, Complex_t* in, long double* out) { fftwl_execute_dft_c2r(plan, in, out); }
+
+            static Plan_t plan_dft_2d(int m, int n, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftwl_plan_dft_2d(m, n, data, data, direction, flags);
+            }
+
+            static Plan_t plan_dft_1d_batch(int n, int n_signals, Complex_t* data, int direction, unsigned flags)
+            {
+                return fftwl_plan_many_dft(1, &n, n_signals, data, nullptr, 1, n, data, nullptr, 1, n, direction, flags);
+            }
+
+            static Plan_t plan_dft_r2c_1d(int n, long double* in, Complex_t* out, unsigned flags)
+            {
+                return fftwl_plan_dft_r2c_1d(n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_r2c_2d(int m, int n, long double* in, Complex_t* out, unsigned flags)
+            {
+                return fftwl_plan_dft_r2c_2d(m, n, in, out, flags);
+            }
+
+            static Plan_t plan_dft_c2r_2d(int m, int n, Complex_t* in, long double* out, unsigned flags)
+            {
+                return fftwl_plan_dft_c2r_2d(m, n, in, out, flags);
+            }
+
+            static bool import_wisdom(const std::string& path) { return fftwl_import_wisdom_from_filename(path.c_str()) != 0; }
+            static bool export_wisdom(const std::string& path) { return fftwl_export_wisdom_to_filename(path.c_str()) != 0; }
+        };
+    }
+
+    inline FourierPlanCache& FourierPlanCache::get()
+    {
+        static FourierPlanCache cache = FourierPlanCache();
+        return cache;
+    }
+
+    inline FourierPlanCache::FourierPlanCache()
+    {
+        set_wisdom_file(get_resource_path() + ".fftw_wisdom");
+    }
+
+    inline FourierPlanCache::~FourierPlanCache()
+    {
+        if (_wisdom_changed)
+            export_wisdom();
+
+        clear();
+    }
+
+    inline void FourierPlanCache::set_planning_rigor(PlanningRigor rigor)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _rigor = rigor;
+    }
+
+    inline PlanningRigor FourierPlanCache::get_planning_rigor() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _rigor;
+    }
+
+    inline bool FourierPlanCache::set_wisdom_file(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::lock_guard<std::mutex> planner_lock(*_planner_mutex);
+        _wisdom_file = path;
+
+        // no short-circuit, all three have to be imported
+        bool imported = detail::FFTW<float>::import_wisdom(path + detail::FFTW<float>::wisdom_suffix);
+        imported = detail::FFTW<double>::import_wisdom(path + detail::FFTW<double>::wisdom_suffix) or imported;
+        imported = detail::FFTW<long double>::import_wisdom(path + detail::FFTW<long double>::wisdom_suffix) or imported;
+
+        return imported;
+    }
+
+    inline std::string FourierPlanCache::get_wisdom_file() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _wisdom_file;
+    }
+
+    inline bool FourierPlanCache::export_wisdom() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::lock_guard<std::mutex> planner_lock(*_planner_mutex);
+
+        bool exported = detail::FFTW<float>::export_wisdom(_wisdom_file + detail::FFTW<float>::wisdom_suffix);
+        exported = detail::FFTW<double>::export_wisdom(_wisdom_file + detail::FFTW<double>::wisdom_suffix) and exported;
+        exported = detail::FFTW<long double>::export_wisdom(_wisdom_file + detail::FFTW<long double>::wisdom_suffix) and exported;
+
+        return exported;
+    }
+
+    inline void FourierPlanCache::clear()
+    {
+        decltype(_plans) released;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            released.swap(_plans);
+        }
+
+        // deleters lock the planner, so plans are released outside of the lock
+        released.clear();
+    }
+
+    template<typename Value_t, typename Plan_Function_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_plan(Key_t key, Plan_Function_t&& plan_function)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+        using Plan_t = typename FFTW::Plan_t;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _plans.find(key);
+        if (it != _plans.end())
+            return std::static_pointer_cast<std::remove_pointer_t<Plan_t>>(it->second);
+
+        Plan_t plan;
+        {
+            std::lock_guard<std::mutex> planner_lock(*_planner_mutex);
+            plan = plan_function(std::get<5>(key));
+        }
+
+        auto out = detail::FFTWPlan<Value_t>(plan, [planner_mutex = _planner_mutex](Plan_t plan){
+            std::lock_guard<std::mutex> planner_lock(*planner_mutex);
+            FFTW::destroy_plan(plan);
+        });
+
+        _plans.emplace(key, out);
+        _wisdom_changed = true;
+        return out;
+    }
+
+    template<typename Value_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_dft_2d(size_t m, size_t n, int direction)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        auto key = Key_t{FFTW::precision, DFT_2D, direction, m, n, static_cast<unsigned>(get_planning_rigor())};
+
+        // measuring overwrites the arrays, so plan on scratch memory. The alignment of fftw-allocated memory always matches
+        return get_plan<Value_t>(key, [&](unsigned flags){
+            auto* scratch = FFTW::alloc_complex(m * n);
+            auto plan = FFTW::plan_dft_2d(m, n, scratch, direction, flags);
+            FFTW::free(scratch);
+            return plan;
+        });
+    }
+
+    template<typename Value_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_dft_1d_batch(size_t n, size_t n_signals, int direction)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        auto key = Key_t{FFTW::precision, DFT_1D_BATCH, direction, n, n_signals, static_cast<unsigned>(get_planning_rigor())};
+
+        return get_plan<Value_t>(key, [&](unsigned flags){
+            auto* scratch = FFTW::alloc_complex(n * n_signals);
+            auto plan = FFTW::plan_dft_1d_batch(n, n_signals, scratch, direction, flags);
+            FFTW::free(scratch);
+            return plan;
+        });
+    }
+
+    template<typename Value_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_dft_r2c_2d(size_t m, size_t n)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        auto key = Key_t{FFTW::precision, DFT_REAL_2D, FFTW_FORWARD, m, n, static_cast<unsigned>(get_planning_rigor())};
+
+        return get_plan<Value_t>(key, [&](unsigned flags){
+            auto* real = FFTW::alloc_real(m * n);
+            auto* complex = FFTW::alloc_complex(m * (n / 2 + 1));
+            auto plan = FFTW::plan_dft_r2c_2d(m, n, real, complex, flags);
+            FFTW::free(real);
+            FFTW::free(complex);
+            return plan;
+        });
+    }
+
+    template<typename Value_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_dft_c2r_2d(size_t m, size_t n)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        auto key = Key_t{FFTW::precision, DFT_REAL_2D, FFTW_BACKWARD, m, n, static_cast<unsigned>(get_planning_rigor())};
+
+        return get_plan<Value_t>(key, [&](unsigned flags){
+            auto* complex = FFTW::alloc_complex(m * (n / 2 + 1));
+            auto* real = FFTW::alloc_real(m * n);
+            auto plan = FFTW::plan_dft_c2r_2d(m, n, complex, real, flags);
+            FFTW::free(complex);
+            FFTW::free(real);
+            return plan;
+        });
+    }
+
+    template<typename Value_t>
+    detail::FFTWPlan<Value_t> FourierPlanCache::get_dft_r2c_1d(size_t n)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        auto key = Key_t{FFTW::precision, DFT_REAL_1D, FFTW_FORWARD, n, 1, static_cast<unsigned>(get_planning_rigor())};
+
+        return get_plan<Value_t>(key, [&](unsigned flags){
+            auto* real = FFTW::alloc_real(n);
+            auto* complex = FFTW::alloc_complex(n / 2 + 1);
+            auto plan = FFTW::plan_dft_r2c_1d(n, real, complex, flags);
+            FFTW::free(real);
+            FFTW::free(complex);
+            return plan;
+        });
+    }
+}
@@ -106,7 +106,7 @@ namespace crisp
         auto* in = fftwf_alloc_real(_size);
         auto* out = fftwf_alloc_complex(_size);
 
-        auto plan = fftwf_plan_dft_r2c_1d(_size, in, out, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_r2c_1d<float>(_size);
 
         bool dither = true;
         for (size_t i = 0; i < _size; ++i)
@@ -115,7 +115,7 @@ namespace crisp
             dither = not dither;
         }
 
-        fftwf_execute(plan);
+        fftwf_execute_dft_r2c(plan.get(), in, out);
 
         _min_spectrum = std::numeric_limits<Value_t>::max();
         _max_spectrum = std::numeric_limits<Value_t>::min();
@@ -137,7 +137,6 @@ namespace crisp
             _max_spectrum = std::max<Value_t>(_max_spectrum, magnitude);
         }
 
-        fftwf_destroy_plan(plan);
         fftwf_free(in);
         fftwf_free(out);
     }
@@ -156,7 +155,7 @@ namespace crisp
         _size = n * 2;
 
         auto* values = fftw_alloc_complex(_size);
-        auto plan = fftw_plan_dft_1d(_size, values, values, FFTW_FORWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_1d_batch<double>(_size, 1, FFTW_FORWARD);
 
         bool dither = true;
         for (size_t i = 0; i < _size; ++i)
@@ -167,7 +166,7 @@ namespace crisp
             dither = not dither;
         }
 
-        fftw_execute(plan);
+        fftw_execute_dft(plan.get(), values, values);
 
         _min_spectrum = std::numeric_limits<Value_t>::max();
         _max_spectrum = std::numeric_limits<Value_t>::min();
@@ -189,7 +188,6 @@ namespace crisp
             _max_spectrum = std::max<Value_t>(_max_spectrum, magnitude);
         }
 
-        fftw_destroy_plan(plan);
         fftw_free(values);
     }
 
@@ -201,7 +199,7 @@ namespace crisp
         out.resize(_size / 2);
 
         auto* values = fftw_alloc_complex(_size);
-        auto plan = fftw_plan_dft_1d(_size, values, values, FFTW_BACKWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_1d_batch<double>(_size, 1, FFTW_BACKWARD);
 
         for (size_t i = 0; i < _size; ++i)
         {
@@ -210,7 +208,7 @@ namespace crisp
             values[i][1] = f.imag();
         }
 
-        fftw_execute(plan);
+        fftw_execute_dft(plan.get(), values, values);
 
         bool dither = true;
         for (size_t i = 0; i < out.size(); ++i)
@@ -14,11 +14,11 @@ namespace crisp
         size_t m = get_size().x(),
                n = get_size().y();
 
-        for (size_t x = 0, i = 0; x < m; ++x)
+        for (size_t x = 0; x < m; ++x)
         {
-            for (size_t y = 0; y < n; ++y, ++i)
+            for (size_t y = 0; y < n; ++y)
             {
-                Value_t value = log(1 + _spectrum.at(i));
+                Value_t value = log(1 + _spectrum.at(to_index(x, y)));
 
                 if (_min_spectrum < 0)
                 {
@@ -46,11 +46,11 @@ namespace crisp
         size_t m = get_size().x(),
              n = get_size().y();
 
-        for (size_t x = 0, i = 0; x < m; ++x)
+        for (size_t x = 0; x < m; ++x)
         {
-            for (size_t y = 0; y < n; ++y, ++i)
+            for (size_t y = 0; y < n; ++y)
             {
-                Value_t value = _phase_angle.at(i);
+                Value_t value = _phase_angle.at(to_index(x, y));
                 value += M_PI;
                 value /= 2 * M_PI;
 
@@ -85,13 +85,13 @@ namespace crisp
     template<FourierTransformMode Mode>
     std::complex<typename FourierTransform<Mode>::Value_t> FourierTransform<Mode>::get_coefficient(size_t x, size_t y) const
     {
-        return std::polar(_spectrum.at(x * y), _phase_angle.at(x * y));
+        return std::polar(_spectrum.at(to_index(x, y)), _phase_angle.at(to_index(x, y)));
     }
 
     template<FourierTransformMode Mode>
     size_t FourierTransform<Mode>::to_index(size_t x, size_t y) const
     {
-        return y + get_size().y()*x;
+        return x + get_size().x()*y;
     }
 
     template<FourierTransformMode Mode>
@@ -152,7 +152,7 @@ namespace crisp
         _size = {m, n};
 
         auto* values = fftwf_alloc_complex(m*n);
-        auto plan = fftwf_plan_dft_2d(m, n, values, values, FFTW_FORWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_2d<float>(n, m, FFTW_FORWARD);
 
         bool dither = true;
         for (size_t y = 0, i = 0; y < n; ++y)
@@ -167,7 +167,7 @@ namespace crisp
             dither = not dither;
         }
 
-        fftwf_execute(plan);
+        fftwf_execute_dft(plan.get(), values, values);
 
         _min_spectrum = std::numeric_limits<Value_t>::max();
         _max_spectrum = std::numeric_limits<Value_t>::min();
@@ -193,7 +193,6 @@ namespace crisp
             }
         }
 
-        fftwf_destroy_plan(plan);
         fftwf_free(values);
     }
 
@@ -208,7 +207,7 @@ namespace crisp
         size_t n = get_size().y();
 
         auto* values = fftwf_alloc_complex(m*n);
-        auto plan = fftwf_plan_dft_2d(m, n, values, values, FFTW_BACKWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_2d<float>(n, m, FFTW_BACKWARD);
 
         for (size_t y = 0, i = 0; y < n; ++y)
         {
@@ -220,7 +219,7 @@ namespace crisp
             }
         }
 
-        fftwf_execute(plan);
+        fftwf_execute_dft(plan.get(), values, values);
 
         bool dither = true; // inverted
         for (size_t y = 0, i = 0; y < n/2; ++y, i += m/2)
@@ -235,7 +234,6 @@ namespace crisp
                 dither = not dither;
         }
 
-        fftwf_destroy_plan(plan);
         fftwf_free(values);
 
         return image_out;
@@ -251,7 +249,7 @@ namespace crisp
         _size = {m, n};
 
         auto* values = fftw_alloc_complex(m*n);
-        auto plan = fftw_plan_dft_2d(m, n, values, values, FFTW_FORWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_2d<double>(n, m, FFTW_FORWARD);
 
         bool dither = true;
         for (size_t y = 0, i = 0; y < n; ++y)
@@ -266,7 +264,7 @@ namespace crisp
             dither = not dither;
         }
 
-        fftw_execute(plan);
+        fftw_execute_dft(plan.get(), values, values);
 
         _min_spectrum = std::numeric_limits<Value_t>::max();
         _max_spectrum = std::numeric_limits<Value_t>::min();
@@ -292,7 +290,6 @@ namespace crisp
             }
         }
 
-        fftw_destroy_plan(plan);
         fftw_free(values);
     }
 
@@ -307,7 +304,7 @@ namespace crisp
         size_t n = get_size().y();
 
         auto* values = fftw_alloc_complex(m*n);
-        auto plan = fftw_plan_dft_2d(m, n, values, values, FFTW_BACKWARD, FFTW_ESTIMATE_PATIENT);
+        auto plan = FourierPlanCache::get().get_dft_2d<double>(n, m, FFTW_BACKWARD);
 
         for (size_t y = 0, i = 0; y < n; ++y)
         {
@@ -319,7 +316,7 @@ namespace crisp
             }
         }
 
-        fftw_execute(plan);
+        fftw_execute_dft(plan.get(), values, values);
 
         bool dither = true; // inverted
         for (size_t y = 0, i = 0; y < n/2; ++y, i += m/2)
@@ -334,7 +331,6 @@ namespace crisp
                 dither = not dither;
         }
 
-        fftw_destroy_plan(plan);
         fftw_free(values);
 
         return image_out;
@@ -350,7 +346,7 @@ namespace crisp
         _size = {m, n};
 
         auto* values = fftwl_alloc_complex(m*n);
-        auto plan = fftwl_plan_dft_2d(m, n, values, values, FFTW_FORWARD, FFTW_ESTIMATE);
+        auto plan = FourierPlanCache::get().get_dft_2d<long double>(n, m, FFTW_FORWARD);
 
         bool dither = true;
         for (size_t y = 0, i = 0; y < n; ++y)
@@ -365,7 +361,7 @@ namespace crisp
             dither = not dither;
         }
 
-        fftwl_execute(plan);
+        fftwl_execute_dft(plan.get(), values, values);
 
         _min_spectrum = std::numeric_limits<Value_t>::max();
         _max_spectrum = std::numeric_limits<Value_t>::min();
@@ -391,7 +387,6 @@ namespace crisp
             }
         }
 
-        fftwl_destroy_plan(plan);
         fftwl_free(values);
     }
 
@@ -406,7 +401,7 @@ namespace crisp
         size_t n = get_size().y();
 
         auto* values = fftwl_alloc_complex(m*n);
-        auto plan = fftwl_plan_dft_2d(m, n, values, values, FFTW_BACKWARD, FFTW_MEASURE);
+        auto plan = FourierPlanCache::get().get_dft_2d<long double>(n, m, FFTW_BACKWARD);
 
         for (size_t y = 0, i = 0; y < n; ++y)
         {
@@ -418,7 +413,7 @@ namespace crisp
             }
         }
 
-        fftwl_execute(plan);
+        fftwl_execute_dft(plan.get(), values, values);
 
         bool dither = true; // inverted
         for (size_t y = 0, i = 0; y < n/2; ++y, i += m/2)
@@ -433,7 +428,6 @@ namespace crisp
                 dither = not dither;
         }
 
-        fftwl_destroy_plan(plan);
         fftwl_free(values);
 
         return image_out;
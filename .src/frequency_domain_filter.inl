@@ -20,6 +20,13 @@ namespace crisp
         as_identity();
     }
 
+    template<FourierTransformMode Mode>
+    FrequencyDomainFilter<CPU_SIDE>::FrequencyDomainFilter(const RealFourierTransform<Mode>& transform)
+    {
+        _size = Vector2ui{transform.get_size().x(), transform.get_size().y()};
+        as_identity();
+    }
+
     const std::vector<double> & FrequencyDomainFilter<CPU_SIDE>::get_values() const
     {
         if (not _values_initialized)
@@ -277,6 +284,21 @@ namespace crisp
                 fourier.get_component(x, y) *= _values.at(i);
     }
 
+    template<FourierTransformMode Mode>
+    void FrequencyDomainFilter<CPU_SIDE>::apply_to(RealFourierTransform<Mode>& fourier) const
+    {
+        assert(fourier.get_size().x() == get_size().x() and fourier.get_size().y() == get_size().y());
+
+        if (not _values_initialized)
+            initialize();
+
+        const size_t n = fourier.get_size().y();
+
+        for (size_t x = 0, i = 0; x < fourier.get_stored_size().x(); ++x)
+            for (size_t y = 0; y < fourier.get_stored_size().y(); ++y, ++i)
+                fourier._spectrum.at(i) *= _values.at(x * n + y);
+    }
+
     FrequencyDomainFilter<CPU_SIDE> FrequencyDomainFilter<CPU_SIDE>::operator+(const FrequencyDomainFilter& other) const
     {
         assert(_size == other._size);
@@ -9,6 +9,7 @@ namespace crisp
 {
     template<size_t N>
     Histogram<N>::Histogram()
+        : _mean(0), _n_sum(0), _counts(N + 1, 0)
     {
         for (size_t i = 0; i <= N; ++i)
             _data.emplace(i, 0);
@@ -26,8 +27,7 @@ namespace crisp
     template<typename Range_t>
     void Histogram<N>::create_from(const Range_t& image)
     {
-        for (auto& pair : _data)
-            pair.second = 0;
+        std::fill(_counts.begin(), _counts.end(), 0);
 
         size_t n = 0;
         float sum = 0;
@@ -37,17 +37,45 @@ namespace crisp
             value = clamp<float>(0, 1, value);
             sum += value;
 
-            value *= N;
-            value = floor(value);
-            _data.at(size_t(value)) += 1;
-
+            _counts[to_bin_index(value)] += 1;
             n += 1;
         }
 
+        for (auto& pair : _data)
+            pair.second = _counts[pair.first];
+
         _mean = double(sum) / double(n);
         _n_sum = n;
     }
 
+    template<size_t N>
+    void Histogram<N>::create_from_counts(std::vector<size_t> counts, double mean)
+    {
+        assert(counts.size() == N + 1);
+
+        _counts = std::move(counts);
+        _n_sum = 0;
+        for (size_t i = 0; i <= N; ++i)
+        {
+            _data[i] = _counts[i];
+            _n_sum += _counts[i];
+        }
+
+        _mean = mean;
+    }
+
+    template<size_t N>
+    size_t Histogram<N>::to_bin_index(float intensity)
+    {
+        return size_t(floor(clamp<float>(0, 1, intensity) * N));
+    }
+
+    template<size_t N>
+    const std::vector<size_t>& Histogram<N>::get_counts() const
+    {
+        return _counts;
+    }
+
     template<size_t N>
     double Histogram<N>::mean() const
     {
@@ -57,13 +85,13 @@ namespace crisp
     template<size_t N>
     size_t Histogram<N>::at(size_t bin_index) const
     {
-        return _data.at(bin_index);
+        return _counts.at(bin_index);
     }
 
     template<size_t N>
     size_t Histogram<N>::get_n_occurrences(float intensity) const
     {
-        return _data.at(floor(intensity * N));
+        return _counts.at(to_bin_index(intensity));
     }
 
     template<size_t N>
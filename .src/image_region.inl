@@ -5,17 +5,227 @@
 
 namespace crisp
 {
-    template<typename Image_t>
-    ImageRegion<Image_t>::Element::Element(Vector2ui position, Value_t value)
+    namespace detail
     {
-        _position = position;
-        _value = value;
-        
-        _intensity = 0;
-        for (size_t i = 0; i < Value_t::size(); ++i)
-            _intensity += float(value.at(i));
-        
-        _intensity /= Value_t::size();
+        // number of elements accumulated by one task in ImageRegion::get_statistics
+        constexpr size_t region_statistics_chunk_size = 1 << 14;
+
+        // running central moments up to order 4, numerically stable single-pass update and pairwise merge
+        // Pébay, P. (2008). Formulas for robust, one-pass parallel computation of covariances and arbitrary-order statistical moments. Sandia Report SAND2008-6212
+        struct MomentAccumulator
+        {
+            size_t n = 0;
+            double mean = 0, m2 = 0, m3 = 0, m4 = 0;
+            float min = std::numeric_limits<float>::max(),
+                  max = std::numeric_limits<float>::lowest();
+
+            void push(float x)
+            {
+                const double n_1 = n;
+                n += 1;
+
+                const double delta = x - mean,
+                             delta_n = delta / n,
+                             delta_n2 = delta_n * delta_n,
+                             term = delta * delta_n * n_1;
+
+                mean += delta_n;
+                m4 += term * delta_n2 * (double(n) * n - 3. * n + 3.) + 6. * delta_n2 * m2 - 4. * delta_n * m3;
+                m3 += term * delta_n * (n - 2.) - 3. * delta_n * m2;
+                m2 += term;
+
+                min = std::min(min, x);
+                max = std::max(max, x);
+            }
+
+            void merge(const MomentAccumulator& other)
+            {
+                if (other.n == 0)
+                    return;
+
+                if (n == 0)
+                {
+                    *this = other;
+                    return;
+                }
+
+                const double n_a = n,
+                             n_b = other.n,
+                             n_ab = n_a + n_b,
+                             delta = other.mean - mean,
+                             delta2 = delta * delta;
+
+                const double m4_ab = m4 + other.m4
+                    + delta2 * delta2 * n_a * n_b * (n_a * n_a - n_a * n_b + n_b * n_b) / (n_ab * n_ab * n_ab)
+                    + 6. * delta2 * (n_a * n_a * other.m2 + n_b * n_b * m2) / (n_ab * n_ab)
+                    + 4. * delta * (n_a * other.m3 - n_b * m3) / n_ab;
+
+                const double m3_ab = m3 + other.m3
+                    + delta2 * delta * n_a * n_b * (n_a - n_b) / (n_ab * n_ab)
+                    + 3. * delta * (n_a * other.m2 - n_b * m2) / n_ab;
+
+                m2 += other.m2 + delta2 * n_a * n_b / n_ab;
+                m3 = m3_ab;
+                m4 = m4_ab;
+                mean += delta * n_b / n_ab;
+                n += other.n;
+
+                min = std::min(min, other.min);
+                max = std::max(max, other.max);
+            }
+        };
+
+        // Hu moment invariants from normalized central moments eta_pq, page 858, 4th edition Image Processing (gonzales, woods)
+        inline std::array<float, 7> compute_hu_moments(double n_20, double n_02, double n_11, double n_30, double n_03, double n_21, double n_12)
+        {
+            const double a = n_30 + n_12,
+                         b = n_21 + n_03;
+
+            return {
+                float(n_20 + n_02),
+                float((n_20 - n_02) * (n_20 - n_02) + 4 * n_11 * n_11),
+                float((n_30 - 3 * n_12) * (n_30 - 3 * n_12) + (3 * n_21 - n_03) * (3 * n_21 - n_03)),
+                float(a * a + b * b),
+                float((n_30 - 3 * n_12) * a * (a * a - 3 * b * b) + (3 * n_21 - n_03) * b * (3 * a * a - b * b)),
+                float((n_20 - n_02) * (a * a - b * b) + 4 * n_11 * a * b),
+                float((3 * n_21 - n_03) * a * (a * a - 3 * b * b) + (3 * n_12 - n_30) * b * (3 * a * a - b * b))
+            };
+        }
+
+        // offsets of chain code directions, increasing counter-clockwise starting at west
+        constexpr std::array<std::array<int, 2>, 8> chain_code_offsets = {{
+            {-1, 0}, {-1, +1}, {0, +1}, {+1, +1}, {+1, 0}, {+1, -1}, {0, -1}, {-1, -1}
+        }};
+
+        // Suzuki-Abe border following on a width x height grid, label_at(x, y) returns the label of a pixel. Each traced pixel is marked
+        // with the index of its contour, negative if the pixel east of it was found to be outside during tracing, so that no contour is
+        // started twice. Pixels of other labels count as outside, so all labels are traced in the same scan
+        template<typename LabelAt_t>
+        std::vector<Contour> trace_contours(size_t width, size_t height, LabelAt_t&& label_at, std::optional<uint32_t> background)
+        {
+            std::vector<Contour> out;
+            std::vector<int32_t> marks(width * height, 0);
+
+            auto is_inside = [&](size_t x, size_t y, int direction, uint32_t label) -> bool
+            {
+                const size_t nx = x + chain_code_offsets[direction][0],
+                             ny = y + chain_code_offsets[direction][1];
+
+                // coordinates left of or above the grid wrap around
+                return nx < width and ny < height and label_at(nx, ny) == label;
+            };
+
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const uint32_t label = label_at(x, y);
+                    if (background.has_value() and label == background.value())
+                        continue;
+
+                    const int32_t mark = marks[x + y * width];
+
+                    // an outer contour starts at an unvisited pixel whose west neighbor is outside, a hole contour at a pixel whose east
+                    // neighbor is outside, unless that side was already traced
+                    const bool is_outer = mark == 0 and not is_inside(x, y, 0, label);
+                    const bool is_hole = not is_outer and mark >= 0 and not is_inside(x, y, 4, label);
+
+                    if (not is_outer and not is_hole)
+                        continue;
+
+                    const int32_t id = out.size() + 1;
+
+                    auto& contour = out.emplace_back();
+                    contour.label = label;
+                    contour.is_hole = is_hole;
+                    contour.start = Vector2ui{x, y};
+
+                    // last pixel of the contour, first inside neighbor clockwise from the outside neighbor
+                    int last_direction = -1;
+                    for (int i = 0; i < 8; ++i)
+                    {
+                        const int direction = ((is_outer ? 0 : 4) - i + 8) % 8;
+                        if (is_inside(x, y, direction, label))
+                        {
+                            last_direction = direction;
+                            break;
+                        }
+                    }
+
+                    if (last_direction == -1)
+                    {
+                        marks[x + y * width] = -id;
+                        continue;
+                    }
+
+                    const size_t last_x = x + chain_code_offsets[last_direction][0],
+                                 last_y = y + chain_code_offsets[last_direction][1];
+
+                    size_t current_x = x,
+                           current_y = y;
+
+                    int previous_direction = last_direction;
+
+                    while (true)
+                    {
+                        // next inside neighbor counter-clockwise from the previous pixel
+                        bool east_is_outside = false;
+                        int direction = previous_direction;
+                        for (int i = 1; i <= 8; ++i)
+                        {
+                            direction = (previous_direction + i) % 8;
+                            if (is_inside(current_x, current_y, direction, label))
+                                break;
+
+                            if (direction == 4)
+                                east_is_outside = true;
+                        }
+
+                        auto& current_mark = marks[current_x + current_y * width];
+                        if (east_is_outside)
+                            current_mark = -id;
+                        else if (current_mark == 0)
+                            current_mark = id;
+
+                        contour.chain_code.push_back(direction);
+
+                        const size_t next_x = current_x + chain_code_offsets[direction][0],
+                                     next_y = current_y + chain_code_offsets[direction][1];
+
+                        if (next_x == x and next_y == y and current_x == last_x and current_y == last_y)
+                            break;
+
+                        previous_direction = (direction + 4) % 8;
+                        current_x = next_x;
+                        current_y = next_y;
+                    }
+                }
+            }
+
+            return out;
+        }
+
+        // minimum number of pixels per stripe in compute_region_properties
+        constexpr size_t min_region_properties_stripe_size = 1 << 14;
+
+        // per-label sums of the first sweep of compute_region_properties
+        struct RegionPropertiesSums
+        {
+            size_t n = 0;
+            size_t min_x = std::numeric_limits<size_t>::max(),
+                   min_y = std::numeric_limits<size_t>::max(),
+                   max_x = 0,
+                   max_y = 0;
+            double x = 0, y = 0, intensity = 0;
+        };
+
+        // per-label central moments of the second sweep of compute_region_properties
+        struct RegionPropertiesMoments
+        {
+            double mu_20 = 0, mu_02 = 0, mu_11 = 0,
+                   mu_30 = 0, mu_03 = 0, mu_21 = 0, mu_12 = 0,
+                   intensity_variance = 0;
+        };
     }
 
     template<typename Image_t>
@@ -24,261 +234,185 @@ namespace crisp
         create_from(segment, image);
     }
 
+    template<typename Image_t>
+    void ImageRegion<Image_t>::push_back_element(Vector2ui position, const Value_t& value)
+    {
+        float intensity = 0;
+        for (size_t i = 0; i < Value_t::size(); ++i)
+            intensity += float(value.at(i));
+
+        _positions.push_back(position);
+        _values.push_back(value);
+        _intensities.push_back(intensity / Value_t::size());
+    }
+
     template<typename Image_t>
     void ImageRegion<Image_t>::create_from(const ImageSegment& segment, const Image_t& image)
     {
-        _elements.clear();
+        _positions.clear();
+        _values.clear();
+        _intensities.clear();
+
+        _positions.reserve(segment.size());
+        _values.reserve(segment.size());
+        _intensities.reserve(segment.size());
+
         for (const auto& px : segment)
-            _elements.insert(std::make_pair(px.to_hash(), Element(px, image(px.x(), px.y()))));
+            push_back_element(px, image._data(px.x(), px.y()));
 
         _original_image_size = image.get_size();
         create();
     }
 
     template<typename Image_t>
-    ImageRegion<Image_t>::ImageRegion(const Image_t& image)
+    ImageRegion<Image_t>::ImageRegion(const RunLengthSegment& segment, const Image_t& image)
     {
-        create_from(image);
+        create_from(segment, image);
     }
 
     template<typename Image_t>
-    void ImageRegion<Image_t>::create_from(const Image_t& image)
+    void ImageRegion<Image_t>::create_from(const RunLengthSegment& segment, const Image_t& image)
     {
-        _elements.clear();
-        for (size_t x = 0; x < image.get_size().x(); ++x)
-            for (size_t y = 0; y < image.get_size().y(); ++y)
-            {
-                auto px = Vector2ui{x, y};
-                _elements.insert(std::make_pair(px.to_hash(), Element(px, image(px.x(), px.y()))));
-            }
+        _positions.clear();
+        _values.clear();
+        _intensities.clear();
+
+        _positions.reserve(segment.size());
+        _values.reserve(segment.size());
+        _intensities.reserve(segment.size());
+
+        for (const auto& run : segment.get_runs())
+            for (size_t x = run.x_begin; x < run.x_end; ++x)
+                push_back_element(Vector2ui{x, run.y}, image._data(x, run.y));
 
         _original_image_size = image.get_size();
         create();
     }
 
     template<typename Image_t>
-    void ImageRegion<Image_t>::create()
+    ImageRegion<Image_t>::ImageRegion(const Image_t& image)
     {
-        _min_x = std::numeric_limits<size_t>::max();
-        _max_x = 0;
-        _min_y = std::numeric_limits<size_t>::max();
-        _max_y = 0;
-        
-        ImageSegment strong_pixels, weak_pixels;
-        
-        for (auto& pair : _elements)
-        {
-            const auto& px = pair.second._position;
-            
-            _min_x = std::min(px.x(), _min_x);
-            _min_y = std::min(px.y(), _min_y);
-            _max_x = std::max(px.x(), _max_x);
-            _max_y = std::max(px.y(), _max_y);
-            
-            size_t n_unconnected = 0;
-            for (int i = -1; i <= +1; ++i)
-            {
-                for (int j = -1; j <= +1; ++j)
-                {
-                    const auto new_px = Vector2i{int(px.x()) + i, int(px.y()) + j};
-
-                    // outer edge of image is always boundary
-                    if (new_px.x() + i < 0 or new_px.x() + i > _original_image_size.x()
-                        or new_px.y() + j < 0 or new_px.y() + j > _original_image_size.y())
-                        n_unconnected++;
-
-                    else if (not (i == 0 and j == 0) and _elements.find(new_px.to_hash()) == _elements.end())
-                        n_unconnected++;
-                }
-            }
-         
-            if (n_unconnected > 1)
-                strong_pixels.insert(px);
-            else if (n_unconnected == 1)
-                weak_pixels.insert(px);
-        }
-
-        // trace boundary
-        _boundary.clear();
+        create_from(image);
+    }
 
-        auto translate_in_direction = [&](Vector2ui c, uint8_t direction) -> Vector2ui
-        {
-            direction = direction % 8;
-            int x_offset, y_offset;
-            switch (direction)
-            {
-                case 0: // WEST
-                    x_offset = -1;
-                    y_offset = 0;
-                    break;
-
-                case 1: // SOUTH WEST
-                    x_offset = -1;
-                    y_offset = +1;
-                    break;
-
-                case 2: // SOUTH
-                    x_offset = 0;
-                    y_offset = +1;
-                    break;
-
-                case 3: // SOUTH EAST
-                    x_offset = +1;
-                    y_offset = +1;
-                    break;
-
-                case 4: // EAST
-                    x_offset = +1;
-                    y_offset = 0;
-                    break;
-
-                case 5: // NORTH EAST
-                    x_offset = +1;
-                    y_offset = -1;
-                    break;
-
-                case 6: // NORTH
-                    x_offset = 0;
-                    y_offset = -1;
-                    break;
-
-                case 7: // NORTH_WEST
-                    x_offset = -1;
-                    y_offset = -1;
-                    break;
-
-                default:
-                    assert(false);
-            }
+    template<typename Image_t>
+    void ImageRegion<Image_t>::create_from(const Image_t& image)
+    {
+        const size_t n = image.get_size().x() * image.get_size().y();
 
-            return Vector2ui{c.x() + x_offset, c.y() + y_offset};
-        };
+        _positions.clear();
+        _values.clear();
+        _intensities.clear();
 
-        std::vector<std::vector<Vector2ui>> boundaries_out;
-        std::vector<std::vector<uint8_t>> directions_out;
+        _positions.reserve(n);
+        _values.reserve(n);
+        _intensities.reserve(n);
 
-        while (not strong_pixels.empty())
-        {
-            boundaries_out.emplace_back();
-            directions_out.emplace_back();
+        for (size_t y = 0; y < image.get_size().y(); ++y)
+            for (size_t x = 0; x < image.get_size().x(); ++x)
+                push_back_element(Vector2ui{x, y}, image._data(x, y));
 
-            auto& boundary = boundaries_out.back();
-            auto& direction = directions_out.back();
+        _original_image_size = image.get_size();
+        create();
+    }
 
-            auto top_left = *strong_pixels.begin();
-            boundary.push_back(top_left);
-            strong_pixels.erase(top_left);
-            direction.push_back(0);
+    template<typename Image_t>
+    size_t ImageRegion<Image_t>::get_element_index(size_t x, size_t y) const
+    {
+        // coordinates left of or above the image wrap around and end up outside the bounding box as well
+        if (_positions.empty() or x < _min_x or x > _max_x or y < _min_y or y > _max_y)
+            return -1;
 
-            size_t current_i = 0;
-            bool finished_maybe = false;
-            do
-            {
-                auto current = boundary.at(current_i);
-                auto current_direction = direction.at(current_i);
+        return size_t(_element_indices[(x - _min_x) + (y - _min_y) * (_max_x - _min_x + 1)]) - 1;
+    }
 
-                bool found = false;
+    template<typename Image_t>
+    bool ImageRegion<Image_t>::contains(Vector2ui position) const
+    {
+        return get_element_index(position.x(), position.y()) != size_t(-1);
+    }
 
-                // check strong candidates
-                for (int dir = current_direction - 1, n = 0; n < 8; ++dir, ++n)
-                {
-                    auto to_check = translate_in_direction(current, dir);
+    template<typename Image_t>
+    void ImageRegion<Image_t>::create()
+    {
+        // descriptors cached for a previous region
+        _statistics_initialized = false;
+        _moment_invariants_initialized = false;
+        _shape_moments_initialized = false;
+        _runs.clear();
+        _nths_statistical_moment.clear();
+        _co_occurrence_matrix.clear();
+        _co_occurrences.clear();
 
-                    if (to_check.x() < _min_x or to_check.x() > _max_x or
-                        to_check.y() < _min_y or to_check.y() > _max_y)
-                        continue;
+        _boundary.clear();
+        _boundary_polygon.clear();
+        _hole_contours.clear();
+        _hole_boundaries.clear();
+        _hole_boundaries_initialized = false;
 
-                    if (to_check == top_left)
-                        finished_maybe = true;
+        if (_positions.empty())
+        {
+            _element_indices.clear();
+            return;
+        }
 
-                    if (strong_pixels.find(to_check) != strong_pixels.end())
-                    {
-                        boundary.push_back(to_check);
-                        direction.push_back(dir);
-                        strong_pixels.erase(to_check);
-                        found = true;
-                        break;
-                    }
-                }
+        _min_x = std::numeric_limits<size_t>::max();
+        _max_x = 0;
+        _min_y = _positions.front().y();
+        _max_y = _positions.back().y();
 
-                if (found)
-                {
-                    current_i = boundary.size() - 1;
-                    continue;
-                }
-                else if (finished_maybe)
-                    break;
+        for (const auto& px : _positions)
+        {
+            _min_x = std::min(px.x(), _min_x);
+            _max_x = std::max(px.x(), _max_x);
+        }
 
-                // check weak candidates
-                for (int dir = current_direction - 1, n = 0; n < 8; ++dir, ++n)
-                {
-                    auto to_check = translate_in_direction(current, dir);
+        const size_t box_width = _max_x - _min_x + 1,
+                     box_height = _max_y - _min_y + 1;
 
-                    if (to_check.x() < _min_x or to_check.x() > _max_x or
-                        to_check.y() < _min_y or to_check.y() > _min_y)
-                        continue;
+        auto to_local = [&](Vector2ui px) -> size_t {
+            return (px.x() - _min_x) + (px.y() - _min_y) * box_width;
+        };
 
-                    if (weak_pixels.find(to_check) != weak_pixels.end())
-                    {
-                        boundary.push_back(to_check);
-                        direction.push_back(dir);
-                        weak_pixels.erase(to_check);
-                        found = true;
-                        break;
-                    }
-                }
+        _element_indices.assign(box_width * box_height, 0);
+        for (size_t i = 0; i < _positions.size(); ++i)
+        {
+            const auto& px = _positions[i];
+            _element_indices[to_local(px)] = i + 1;
 
-                if (found)
-                {
-                    current_i = boundary.size() - 1;
-                    continue;
-                }
-                else
-                {
-                    if (current_i == 0)
-                        break;
-                    else
-                        current_i--;
-                }
-            } while (true);
+            if (not _runs.empty() and _runs.back().y == px.y() and _runs.back().x_end == px.x())
+                _runs.back().x_end += 1;
+            else
+                _runs.push_back({px.y(), px.x(), px.x() + 1});
         }
 
-        _boundary = boundaries_out.at(0);
+        // trace the region inside its bounding box, the first contour is the outer boundary as it starts at the first pixel.
+        // Parts of a region that is not connected are not part of its boundary
+        auto contours = detail::trace_contours(box_width, box_height, [&](size_t x, size_t y) -> uint32_t {
+            return _element_indices[x + y * box_width] != 0;
+        }, 0);
 
-        _hole_boundaries.clear();
-        for (size_t i = 1; i < boundaries_out.size(); ++i)
-            _hole_boundaries.push_back(boundaries_out.at(i));
+        for (auto& contour : contours)
+            contour.start = Vector2ui{contour.start.x() + _min_x, contour.start.y() + _min_y};
 
-        // boundary polygon
-        auto turn_type = [&](size_t i_a, size_t i_b) -> int
-        {
-            auto point_a = _boundary.at(i_a),
-                 point_b = _boundary.at(i_b);
+        const auto& outer = contours.front();
+        _boundary = outer.to_points();
 
-            // warp point
-            if (abs(int(point_a.x()) - int(point_b.x())) > 1 or
-                abs(int(point_a.y()) - int(point_b.y())) > 1)
-                return 0;
+        for (auto& contour : contours)
+            if (contour.is_hole)
+                _hole_contours.push_back(std::move(contour));
 
-            auto dir_a = directions_out.at(0).at(i_a),
-                 dir_b = directions_out.at(0).at(i_b);
+        // boundary polygon, vertices are all pixels at which the direction of the boundary changes
+        const auto& chain_code = outer.chain_code;
+        const size_t n = chain_code.size();
 
-            if (dir_b > dir_a or (dir_a == 7 and dir_b == 0))
-                return -1; // left-hand turn
-            else if (dir_b < dir_a or (dir_a == 0 and dir_b == 7))
-                return +1; // right-hand turn
-            else
-                return 0; // colinear
-        };
-
-        _boundary_polygon.clear();
         _centroid = Vector2f{0, 0};
 
-        for (size_t i = 0; i < _boundary.size() - 1; ++i)
+        for (size_t i = 0; i < _boundary.size(); ++i)
         {
             _centroid += Vector2f{float(_boundary.at(i).x()), float(_boundary.at(i).y())};
 
-            if (turn_type(i, i+1) != 0)
+            if (n == 0 or chain_code[(i + n - 1) % n] != chain_code[i])
                 _boundary_polygon.push_back(_boundary.at(i));
         }
 
@@ -286,6 +420,7 @@ namespace crisp
 
         // compute minor and major axis
         Eigen::Matrix<float, 2, 2> covar;
+        covar.setZero();
 
         for (auto& px : _boundary)
         {
@@ -297,7 +432,7 @@ namespace crisp
             covar += current_covar;
         }
 
-        covar /= _elements.size();
+        covar /= _positions.size();
 
         auto eigens = Eigen::EigenSolver<decltype(covar)>(covar);
 
@@ -324,7 +459,7 @@ namespace crisp
             _minor_axis.first = to_crisp_vec(centroid - l2 * e2);
             _minor_axis.second = to_crisp_vec(centroid + l2 * e2);
 
-            _eccentricity = sqrt(1 - (l1 / l2) * (l1 / l2));
+            _eccentricity = sqrt(1 - (l2 / l1) * (l2 / l1));
         }
         else
         {
@@ -334,7 +469,7 @@ namespace crisp
             _minor_axis.first = to_crisp_vec(centroid - l1 * e1);
             _minor_axis.second = to_crisp_vec(centroid + l1 * e1);
 
-            _eccentricity = sqrt(1 - (l2 / l1) * (l2 / l1));
+            _eccentricity = sqrt(1 - (l1 / l2) * (l1 / l2));
         }
     }
     
@@ -350,11 +485,96 @@ namespace crisp
         return _boundary;
     }
     
+    template<typename Image_t>
+    size_t ImageRegion<Image_t>::get_n_holes() const
+    {
+        return _hole_contours.size();
+    }
+
+    template<typename Image_t>
+    const std::vector<std::vector<Vector2ui>>& ImageRegion<Image_t>::get_hole_boundaries() const
+    {
+        if (not _hole_boundaries_initialized)
+        {
+            _hole_boundaries.clear();
+            _hole_boundaries.reserve(_hole_contours.size());
+
+            for (const auto& contour : _hole_contours)
+                _hole_boundaries.push_back(contour.to_points());
+
+            _hole_boundaries_initialized = true;
+        }
+
+        return _hole_boundaries;
+    }
+
     template<typename Image_t>
     const std::vector<Vector2ui>& ImageRegion<Image_t>::get_boundary_polygon() const
     {
         return _boundary_polygon;
     }
+
+    template<typename Image_t>
+    std::vector<Vector2ui> ImageRegion<Image_t>::get_simplified_boundary_polygon(float tolerance, PolygonSimplification algorithm) const
+    {
+        // boundary pixels not in the polygon lie on straight lines between its vertices, so they never change the result
+        return simplify_polygon(_boundary_polygon, tolerance, algorithm);
+    }
+
+    template<typename Image_t>
+    std::vector<Vector2ui> ImageRegion<Image_t>::get_row_extremes() const
+    {
+        // runs are in scan order, so all runs of a row are consecutive
+        std::vector<Vector2ui> out;
+        for (size_t i = 0; i < _runs.size();)
+        {
+            const size_t y = _runs[i].y,
+                         x_begin = _runs[i].x_begin;
+
+            while (i + 1 < _runs.size() and _runs[i + 1].y == y)
+                ++i;
+
+            out.push_back(Vector2ui{x_begin, y});
+            if (_runs[i].x_end - 1 != x_begin)
+                out.push_back(Vector2ui{_runs[i].x_end - 1, y});
+
+            ++i;
+        }
+
+        return out;
+    }
+
+    template<typename Image_t>
+    std::vector<Vector2ui> ImageRegion<Image_t>::get_convex_hull() const
+    {
+        // taken over all rows rather than the boundary polygon, which only encloses the first part of a region that is not connected
+        return convex_hull(get_row_extremes());
+    }
+
+    template<typename Image_t>
+    float ImageRegion<Image_t>::get_solidity() const
+    {
+        // the hull of the corners of the hull vertices contains the corners of all pixels, so it covers the same pixels as the area
+        std::vector<Vector2f> corners;
+        for (const auto& px : get_convex_hull())
+            for (float x_offset : {-0.5f, 0.5f})
+                for (float y_offset : {-0.5f, 0.5f})
+                    corners.push_back(Vector2f{px.x() + x_offset, px.y() + y_offset});
+
+        return _positions.size() / polygon_area(convex_hull(corners));
+    }
+
+    template<typename Image_t>
+    std::vector<ConvexityDefect> ImageRegion<Image_t>::get_convexity_defects(float min_depth) const
+    {
+        return convexity_defects(_boundary_polygon, min_depth);
+    }
+
+    template<typename Image_t>
+    RotatedRectangle ImageRegion<Image_t>::get_minimum_area_rectangle() const
+    {
+        return minimum_area_rectangle(get_row_extremes());
+    }
     
     template<typename Image_t>
     std::vector<float> ImageRegion<Image_t>::farthest_point_signature() const
@@ -468,108 +688,147 @@ namespace crisp
     template<typename Image_t>
     float ImageRegion<Image_t>::get_area() const
     {
-        return _elements.size();
+        return _positions.size();
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_compactness() const
     {
-        return (_boundary.size() * _boundary.size()) / float(_elements.size());
+        return (_boundary.size() * _boundary.size()) / float(_positions.size());
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_circularity() const
     {
-        return 4*M_PI*_elements.size() / float(_boundary.size() * _boundary.size());
+        return 4*M_PI*_positions.size() / float(_boundary.size() * _boundary.size());
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_nths_moment_invariant(size_t i)
     {
+        assert(i != 0 and i <= 7 && "only moments for n = {1, 2, 3, 4, 5, 6, 7} are supported");
+
+        if (_moment_invariants_initialized)
+            return _moment_invariants.at(i - 1);
+
         // page 858, 4th edition Image Processing (gonzales, woods)
-        auto normalized_central_moment = [&](size_t p, size_t q)
+        double m_00 = 0, m_10 = 0, m_01 = 0;
+        for (size_t j = 0; j < _positions.size(); ++j)
         {
-            float moment = 0,
-                  value_sum = 0;
-            for (auto& element : _elements)
-            {
-                value_sum += powf(element.position.x() - _centroid.x(), p) * 
-                             powf(element.position.y() - _centroid.y(), q) * 
-                             element._intensity;
-            }
+            m_00 += _intensities[j];
+            m_10 += double(_positions[j].x()) * _intensities[j];
+            m_01 += double(_positions[j].y()) * _intensities[j];
+        }
 
-            return moment / powf(value_sum, (p+q) / 2.f + 1);
+        const double x_mean = m_10 / m_00,
+                     y_mean = m_01 / m_00;
+
+        double mu_20 = 0, mu_02 = 0, mu_11 = 0, mu_30 = 0, mu_03 = 0, mu_21 = 0, mu_12 = 0;
+        for (size_t j = 0; j < _positions.size(); ++j)
+        {
+            const double dx = _positions[j].x() - x_mean,
+                         dy = _positions[j].y() - y_mean,
+                         w = _intensities[j];
+
+            mu_20 += dx * dx * w;
+            mu_02 += dy * dy * w;
+            mu_11 += dx * dy * w;
+            mu_30 += dx * dx * dx * w;
+            mu_03 += dy * dy * dy * w;
+            mu_21 += dx * dx * dy * w;
+            mu_12 += dx * dy * dy * w;
+        }
+
+        auto eta = [&](double mu, size_t p, size_t q) {
+            return mu / std::pow(m_00, (p + q) / 2. + 1);
         };
 
-        assert(i != 0 and i <= 7 && "only moments for n = {1, 2, 3, 4, 5, 6, 7} are supported");
+        _moment_invariants = detail::compute_hu_moments(
+            eta(mu_20, 2, 0), eta(mu_02, 0, 2), eta(mu_11, 1, 1),
+            eta(mu_30, 3, 0), eta(mu_03, 0, 3), eta(mu_21, 2, 1), eta(mu_12, 1, 2)
+        );
 
-        if (i == 1)
-        {
-            float m_20 = normalized_central_moment(2, 0);
-            float m_02 = normalized_central_moment(0, 2);
+        _moment_invariants_initialized = true;
+        return _moment_invariants.at(i - 1);
+    }
 
-            return m_20 + m_02;
-        }
-        else if (i == 2)
-        {
-            float m_20 = normalized_central_moment(2, 0);
-            float m_02 = normalized_central_moment(0, 2);
-            float m_11 = normalized_central_moment(1, 1);
+    template<typename Image_t>
+    const ShapeMoments& ImageRegion<Image_t>::get_shape_moments() const
+    {
+        if (_shape_moments_initialized)
+            return _shape_moments;
 
-            return pow(m_20 - m_02, 2) + 4 * (pow(m_11, 2));
-        }
-        else if (i == 3)
-        {
-            float m_30 = normalized_central_moment(3, 0);
-            float m_03 = normalized_central_moment(0, 3);
-            float m_12 = normalized_central_moment(1, 2);
-            float m_21 = normalized_central_moment(2, 1);
+        auto& out = _shape_moments;
+        out = ShapeMoments();
 
-            return pow(m_30 - 3*m_12, 2) + pow(3*m_21 - m_03, 2);
-        }
-        else if (i == 4)
+        // discrete Green's theorem: the sum of x^p over a run [a, b] is S_p(b) - S_p(a - 1), where S_p(n) = 0^p + 1^p + ... + n^p,
+        // so each run only contributes through its two ends. Coordinates are relative to the bounding box to keep the powers small
+        auto power_sum = [](double n, size_t p) -> double
         {
-            float m_30 = normalized_central_moment(3, 0);
-            float m_03 = normalized_central_moment(0, 3);
-            float m_12 = normalized_central_moment(1, 2);
-            float m_21 = normalized_central_moment(2, 1);
+            switch (p)
+            {
+                case 0: return n + 1;
+                case 1: return n * (n + 1) / 2;
+                case 2: return n * (n + 1) * (2 * n + 1) / 6;
+                default: return (n * (n + 1) / 2) * (n * (n + 1) / 2);
+            }
+        };
 
-            return pow(m_30 + m_12, 2) + pow(m_21 + m_03, 2);
-        }
-        else if (i == 5)
+        std::array<std::array<double, 4>, 4> local = {};
+        for (const auto& run : _runs)
         {
-            float m_30 = normalized_central_moment(3, 0);
-            float m_03 = normalized_central_moment(0, 3);
-            float m_12 = normalized_central_moment(1, 2);
-            float m_21 = normalized_central_moment(2, 1);
+            const double a = double(run.x_begin) - double(_min_x),
+                         b = double(run.x_end - 1) - double(_min_x),
+                         y = double(run.y) - double(_min_y);
+
+            double y_power = 1;
+            for (size_t q = 0; q <= 3; ++q)
+            {
+                for (size_t p = 0; p + q <= 3; ++p)
+                    local[p][q] += (power_sum(b, p) - power_sum(a - 1, p)) * y_power;
 
-            return (m_30 - 3 * m_12) * (m_30 + m_12) * (pow(m_30 + m_12, 2) - 3 * pow(m_21 + m_03, 2)) +
-                    (3 * m_21 - m_03) * (m_21 + m_03) * (3 * pow(m_30 + m_12, 2) - pow(m_21 + m_03, 2));
+                y_power *= y;
+            }
         }
-        else if (i == 6)
-        {
-            float m_20 = normalized_central_moment(2, 0);
-            float m_02 = normalized_central_moment(0, 2);
-            float m_30 = normalized_central_moment(3, 0);
-            float m_03 = normalized_central_moment(0, 3);
-            float m_12 = normalized_central_moment(1, 2);
-            float m_21 = normalized_central_moment(2, 1);
-            float m_11 = normalized_central_moment(1, 1);
 
-            return (m_20 - m_02) * (pow(m_30 + m_12, 2) - (pow(m_21 + m_03, 2))) + 4 * m_11 * (m_30 + m_12) * (m_21 + m_03);
+        const double m_00 = local[0][0];
+        if (m_00 == 0)
+        {
+            _shape_moments_initialized = true;
+            return out;
         }
-        else if (i == 7)
+
+        const double x_mean = local[1][0] / m_00,
+                     y_mean = local[0][1] / m_00;
+
+        // binomial expansion of (x + offset)^p, used both to center and to translate back into image coordinates
+        auto shift = [](const std::array<std::array<double, 4>, 4>& moments, double x_offset, double y_offset)
         {
-            float m_20 = normalized_central_moment(2, 0);
-            float m_02 = normalized_central_moment(0, 2);
-            float m_30 = normalized_central_moment(3, 0);
-            float m_03 = normalized_central_moment(0, 3);
-            float m_12 = normalized_central_moment(1, 2);
-            float m_21 = normalized_central_moment(2, 1);
+            static constexpr double binomial[4][4] = {{1, 0, 0, 0}, {1, 1, 0, 0}, {1, 2, 1, 0}, {1, 3, 3, 1}};
 
-            return (3 * m_21 - m_03) * (m_30 + m_12) * (pow(m_30 + m_12, 2) - 3 * pow(m_21 + m_03, 2)) +
-                    (3 * m_12 - m_30) * (m_21 + m_03) * (3 * pow(m_30 + m_12, 2) - pow(m_21 + m_03, 2));
-        }
+            std::array<std::array<double, 4>, 4> shifted = {};
+            for (size_t p = 0; p <= 3; ++p)
+                for (size_t q = 0; p + q <= 3; ++q)
+                    for (size_t r = 0; r <= p; ++r)
+                        for (size_t s = 0; s <= q; ++s)
+                            shifted[p][q] += binomial[p][r] * binomial[q][s] * std::pow(x_offset, p - r) * std::pow(y_offset, q - s) * moments[r][s];
+
+            return shifted;
+        };
+
+        out.central = shift(local, -x_mean, -y_mean);
+        out.raw = shift(local, double(_min_x), double(_min_y));
+        out.centroid = Vector2f{float(x_mean + _min_x), float(y_mean + _min_y)};
+
+        for (size_t p = 0; p <= 3; ++p)
+            for (size_t q = 0; p + q <= 3; ++q)
+                out.normalized[p][q] = out.central[p][q] / std::pow(m_00, (p + q) / 2. + 1);
+
+        const auto& eta = out.normalized;
+        out.hu_moments = detail::compute_hu_moments(eta[2][0], eta[0][2], eta[1][1], eta[3][0], eta[0][3], eta[2][1], eta[1][2]);
+
+        _shape_moments_initialized = true;
+        return out;
     }
 
     template<typename Image_t>
@@ -585,50 +844,119 @@ namespace crisp
     }
 
     template<typename Image_t>
-    const auto& ImageRegion<Image_t>::get_intensity_histogram() const
+    float ImageRegion<Image_t>::get_eccentricity() const
     {
-        if (_histogram_initialized)
-            return _histogram;
+        return _eccentricity;
+    }
 
-        std::vector<float> intensities;
-        intensities.reserve(_elements.size());
+    template<typename Image_t>
+    const RegionStatistics& ImageRegion<Image_t>::get_statistics() const
+    {
+        if (_statistics_initialized)
+            return _statistics;
 
-        for (auto& pair : _elements)
-            intensities.push_back(pair.second._intensity);
+        const size_t n_elements = _intensities.size();
+        const size_t n_chunks = (n_elements + detail::region_statistics_chunk_size - 1) / detail::region_statistics_chunk_size;
+
+        std::vector<detail::MomentAccumulator> accumulators(n_chunks);
+        std::vector<std::vector<size_t>> counts(n_chunks);
+
+        ThreadPool::get().parallel_for(n_chunks, [&](size_t chunk)
+        {
+            auto& accumulator = accumulators[chunk];
+            auto& chunk_counts = counts[chunk];
+            chunk_counts.resize(QUANTIZATION_N + 1, 0);
 
-        _histogram = Histogram<QUANTIZATION_N>(intensities);
-        _histogram_initialized = true;
-        return _histogram;
+            for (size_t i = chunk * detail::region_statistics_chunk_size; i < std::min(n_elements, (chunk + 1) * detail::region_statistics_chunk_size); ++i)
+            {
+                accumulator.push(_intensities[i]);
+                chunk_counts[Histogram<QUANTIZATION_N>::to_bin_index(_intensities[i])] += 1;
+            }
+        });
+
+        // merge in chunk order, results do not depend on the number of threads
+        detail::MomentAccumulator total;
+        std::vector<size_t> total_counts(QUANTIZATION_N + 1, 0);
+        for (size_t chunk = 0; chunk < n_chunks; ++chunk)
+        {
+            total.merge(accumulators[chunk]);
+            for (size_t i = 0; i <= QUANTIZATION_N; ++i)
+                total_counts[i] += counts[chunk][i];
+        }
+
+        auto& out = _statistics;
+        out = RegionStatistics();
+        out.n = total.n;
+
+        if (total.n > 0)
+        {
+            const double n = total.n,
+                         mean = total.mean,
+                         c2 = total.m2 / n,
+                         c3 = total.m3 / n,
+                         c4 = total.m4 / n;
+
+            out.mean = mean;
+            out.variance = c2;
+            out.skewness = c2 > 0 ? c3 / std::pow(c2, 1.5) : 0;
+            out.kurtosis = c2 > 0 ? c4 / (c2 * c2) : 0;
+
+            out.central_moments = {1.f, 0.f, float(c2), float(c3), float(c4)};
+            out.raw_moments = {
+                1.f,
+                float(mean),
+                float(c2 + mean * mean),
+                float(c3 + 3 * mean * c2 + mean * mean * mean),
+                float(c4 + 4 * mean * c3 + 6 * mean * mean * c2 + mean * mean * mean * mean)
+            };
+
+            out.min = total.min;
+            out.max = total.max;
+
+            size_t max_count = 0;
+            double entropy = 0;
+            for (size_t count : total_counts)
+            {
+                max_count = std::max(max_count, count);
+
+                if (count == 0)
+                    continue;
+
+                double p = count / n;
+                entropy -= p * std::log2(p);
+            }
+
+            out.max_probability = max_count / n;
+            out.average_entropy = entropy / std::log2(double(QUANTIZATION_N + 1));
+        }
+
+        // histogram clamps values into [0, 1] before computing the mean
+        double clamped_sum = 0;
+        for (size_t i = 0; i < n_elements; ++i)
+            clamped_sum += clamp<float>(0, 1, _intensities[i]);
+
+        out.histogram.create_from_counts(std::move(total_counts), n_elements > 0 ? clamped_sum / n_elements : 0);
+
+        _statistics_initialized = true;
+        return _statistics;
     }
 
     template<typename Image_t>
-    float ImageRegion<Image_t>::get_mean() const
+    const auto& ImageRegion<Image_t>::get_intensity_histogram() const
     {
-        if (_intensity_mean != -1)
-            return _intensity_mean;
-
-        float sum = 0;
-        for (auto& pair : _elements)
-            sum += pair.second._intensity;
+        return get_statistics().histogram;
+    }
 
-        _intensity_mean = sum / _elements.size();
-        return _intensity_mean;
+    template<typename Image_t>
+    float ImageRegion<Image_t>::get_mean() const
+    {
+        return get_statistics().mean;
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_variance() const
     {
-        if (_intensity_variance != -1)
-            return _intensity_variance;
-
-        const float mean = get_mean();
-
-        float sum = 0;
-        for (auto& pair : _elements)
-            sum += (pair.second._intensity - mean) * (pair.second._intensity - mean);
-
-        _intensity_variance = sum / _elements.size();
-        return _intensity_variance;
+        return get_statistics().variance;
     }
 
     template<typename Image_t>
@@ -640,6 +968,10 @@ namespace crisp
             return 0;
         else if (n == 2)
             return 1;
+        else if (n == 3)
+            return get_statistics().skewness;
+        else if (n == 4)
+            return get_statistics().kurtosis;
 
         if (_nths_statistical_moment.find(n) != _nths_statistical_moment.end())
             return _nths_statistical_moment.at(n);
@@ -648,11 +980,11 @@ namespace crisp
         const float stddev = sqrt(get_variance());
 
         float sum = 0;
-        for (auto& pair : _elements)
-            sum += pow((pair.second._intensity - mean), n);
+        for (float intensity : _intensities)
+            sum += pow((intensity - mean), n);
 
         sum /= pow(stddev, n);
-        sum /= float(_elements.size());
+        sum /= float(_intensities.size());
         _nths_statistical_moment[n] = sum;
         return sum;
     }
@@ -660,167 +992,342 @@ namespace crisp
     template<typename Image_t>
     float ImageRegion<Image_t>::get_skewness() const
     {
-        return get_nths_moment(3);
+        return get_statistics().skewness;
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_kurtosis() const
     {
-        return get_nths_moment(4);
+        return get_statistics().kurtosis;
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_maximum_intensity_probability() const
     {
-        if (_max_probability != -1)
-            return _average_entropy;
+        return get_statistics().max_probability;
+    }
 
-        if (not _intensity_occurrences_initialized)
-        {
-            for (const auto& pair : _elements)
-            {
-                float intensity = pair.second._intensity;
-                if (_intensity_occurrences.find(intensity) == _intensity_occurrences.end())
-                    _intensity_occurrences.emplace(intensity, 1);
-                else
-                {
-                    _intensity_occurrences.at(intensity) += 1;
-                }
-            }
+    template<typename Image_t>
+    float ImageRegion<Image_t>::get_average_entropy() const
+    {
+        return get_statistics().average_entropy;
+    }
 
-            _intensity_occurrences_initialized = true;
-        }
+    inline size_t Contour::size() const
+    {
+        return std::max<size_t>(chain_code.size(), 1);
+    }
+
+    inline std::vector<Vector2ui> Contour::to_points() const
+    {
+        std::vector<Vector2ui> out;
+        out.reserve(size());
+
+        Vector2ui current = start;
+        out.push_back(current);
 
-        size_t max_n = 0;
-        float n = 0;
-        for (const auto& pair : _intensity_occurrences)
+        // the last code leads back to start
+        for (size_t i = 0; i + 1 < chain_code.size(); ++i)
         {
-            max_n = std::max(pair.second, max_n);
-            n++;
+            current = Vector2ui{current.x() + detail::chain_code_offsets[chain_code[i]][0], current.y() + detail::chain_code_offsets[chain_code[i]][1]};
+            out.push_back(current);
         }
 
-        return max_n / n;
+        return out;
+    }
+
+    inline std::vector<Contour> trace_contours(const Image<uint32_t, 1>& labels, std::optional<uint32_t> background)
+    {
+        const auto& data = labels._data;
+        return detail::trace_contours(labels.get_size().x(), labels.get_size().y(), [&](size_t x, size_t y) -> uint32_t {
+            return data(x, y).x();
+        }, background);
+    }
+
+    inline float CoOccurrenceMatrix::at(size_t row, size_t col) const
+    {
+        auto it = std::lower_bound(entries.begin(), entries.end(), std::make_pair(row, col), [](const Entry& entry, const std::pair<size_t, size_t>& index){
+            return entry.row != index.first ? entry.row < index.first : entry.col < index.second;
+        });
+
+        if (it == entries.end() or it->row != row or it->col != col)
+            return 0;
+
+        return it->probability;
+    }
+
+    inline Eigen::MatrixXf CoOccurrenceMatrix::as_dense() const
+    {
+        Eigen::MatrixXf out;
+        out.resize(n_levels, n_levels);
+        out.setConstant(0);
+
+        for (const auto& entry : entries)
+            out(entry.row, entry.col) = entry.probability;
+
+        return out;
     }
 
     template<typename Image_t>
-    float ImageRegion<Image_t>::get_average_entropy() const
+    const CoOccurrenceMatrix& ImageRegion<Image_t>::get_co_occurrence(CoOccurrenceDirection direction, size_t n_levels) const
     {
-        if (_average_entropy != -1)
-            return _average_entropy;
-        
-        if (not _intensity_occurrences_initialized)
+        assert(n_levels >= 2 and n_levels <= 256);
+
+        auto it = _co_occurrences.find(n_levels);
+        if (it != _co_occurrences.end())
+            return it->second.at(direction);
+
+        auto& out = _co_occurrences[n_levels];
+        for (auto& matrix : out)
+            matrix.n_levels = n_levels;
+
+        if (_positions.empty())
+            return out.at(direction);
+
+        // dense grid of quantized intensities of the bounding box, pixels outside the region are marked
+        constexpr uint16_t outside = std::numeric_limits<uint16_t>::max();
+
+        const size_t box_width = _max_x - _min_x + 1,
+                     box_height = _max_y - _min_y + 1;
+
+        std::vector<uint16_t> levels(box_width * box_height, outside);
+        for (size_t i = 0; i < _positions.size(); ++i)
+        {
+            const size_t level = std::min<size_t>(std::max(_intensities[i], 0.f) * n_levels, n_levels - 1);
+            levels[(_positions[i].x() - _min_x) + (_positions[i].y() - _min_y) * box_width] = level;
+        }
+
+        // in order of CoOccurrenceDirection
+        static constexpr std::array<std::array<int, 2>, 8> offsets = {{
+            {0, -1}, {+1, -1}, {+1, 0}, {+1, +1}, {0, +1}, {-1, +1}, {-1, 0}, {-1, -1}
+        }};
+
+        // each direction has at most one pair per pixel, so small regions collect the pair codes and sort them
+        // instead of zeroing and scanning a dense n_levels * n_levels count matrix per direction
+        const bool sparse = _positions.size() * 8 < n_levels * n_levels;
+
+        std::vector<std::vector<uint32_t>> counts(8);
+        for (auto& direction_counts : counts)
         {
-            for (auto& pair : _elements)
+            if (sparse)
+                direction_counts.reserve(_positions.size());
+            else
+                direction_counts.resize(n_levels * n_levels, 0);
+        }
+
+        std::array<size_t, 8> n_pairs = {0, 0, 0, 0, 0, 0, 0, 0};
+
+        // one pass for all directions, interior rows and columns skip the bounds checks
+        for (size_t y = 0; y < box_height; ++y)
+        {
+            for (size_t x = 0; x < box_width; ++x)
             {
-                float intensity = pair.second._intensity;
-                if (_intensity_occurrences.find(intensity) == _intensity_occurrences.end())
-                    _intensity_occurrences.emplace(intensity, 1);
-                else
-                    _intensity_occurrences.at(intensity) += 1;
-            }
+                const size_t i = x + y * box_width;
+                const uint16_t a = levels[i];
+
+                if (a == outside)
+                    continue;
+
+                const bool interior = x > 0 and x + 1 < box_width and y > 0 and y + 1 < box_height;
+
+                for (size_t d = 0; d < 8; ++d)
+                {
+                    if (not interior and (
+                        (offsets[d][0] < 0 and x == 0) or (offsets[d][0] > 0 and x + 1 == box_width) or
+                        (offsets[d][1] < 0 and y == 0) or (offsets[d][1] > 0 and y + 1 == box_height)))
+                        continue;
+
+                    const uint16_t b = levels[i + offsets[d][0] + offsets[d][1] * int(box_width)];
+
+                    if (b == outside)
+                        continue;
+
+                    if (sparse)
+                        counts[d].push_back(a * n_levels + b);
+                    else
+                        counts[d][a * n_levels + b] += 1;
 
-            _intensity_occurrences_initialized = true;
+                    n_pairs[d] += 1;
+                }
+            }
         }
 
-        float sum = 0;
-        for (auto& pair : _intensity_occurrences)
+        for (size_t d = 0; d < 8; ++d)
         {
-            float p = pair.second / float(_intensity_occurrences.size());
-            sum += p * log2(p);
+            auto& matrix = out[d];
+            matrix.n_pairs = n_pairs[d];
+
+            if (sparse)
+            {
+                // run-length encode the sorted codes, row-major order same as the dense case
+                auto& codes = counts[d];
+                std::sort(codes.begin(), codes.end());
+
+                for (size_t i = 0; i < codes.size();)
+                {
+                    size_t run_end = i;
+                    while (run_end < codes.size() and codes[run_end] == codes[i])
+                        ++run_end;
+
+                    matrix.entries.push_back({uint16_t(codes[i] / n_levels), uint16_t(codes[i] % n_levels), (run_end - i) / float(n_pairs[d])});
+                    i = run_end;
+                }
+            }
+            else
+            {
+                for (size_t i = 0; i < counts[d].size(); ++i)
+                    if (counts[d][i] != 0)
+                        matrix.entries.push_back({uint16_t(i / n_levels), uint16_t(i % n_levels), counts[d][i] / float(n_pairs[d])});
+            }
         }
 
-        _average_entropy = (-1 * sum) / (2 * log2(_intensity_occurrences.size()));
-        return _average_entropy;
+        return out.at(direction);
     }
-    
+
     template<typename Image_t>
     const auto & ImageRegion<Image_t>::get_co_occurrence_matrix(CoOccurrenceDirection direction) const
     {
-        if (_co_occurrence_matrix.find(direction) != _co_occurrence_matrix.end())
-            return _co_occurrence_matrix.at(direction);
+        if (_co_occurrence_matrix.find(direction) == _co_occurrence_matrix.end())
+            _co_occurrence_matrix.emplace(direction, get_co_occurrence(direction, QUANTIZATION_N).as_dense());
 
-        using Value_t = typename Image_t::Value_t;
-        using Inner_t = typename Image_t::Value_t::Value_t;
+        return _co_occurrence_matrix.at(direction);
+    }
 
-        Eigen::MatrixXf out;
-        out.resize(QUANTIZATION_N, QUANTIZATION_N);
-        out.setConstant(0);
+    template<typename Image_t>
+    HaralickFeatures ImageRegion<Image_t>::get_haralick_features(CoOccurrenceDirection direction, size_t n_levels) const
+    {
+        const auto& matrix = get_co_occurrence(direction, n_levels);
+        const size_t n = matrix.n_levels;
+
+        HaralickFeatures out;
 
-        size_t n_pairs = 0;
-        auto process = [&](size_t x, size_t y, size_t x_2, size_t y_2)
+        if (matrix.entries.empty())
+            return out;
+
+        // marginals, distribution of sums (index i + j) and absolute differences (index |i - j|) of pairs
+        std::vector<double> p_x(n, 0), p_y(n, 0), p_sum(2 * n - 1, 0), p_difference(n, 0);
+
+        double asm_sum = 0, contrast = 0, idm = 0, entropy = 0, ij_sum = 0;
+        for (const auto& entry : matrix.entries)
         {
-            auto a = _elements.find(Vector2ui{x, y}.to_hash());
-            auto b = _elements.find(Vector2ui{x_2, y_2}.to_hash());
+            const double p = entry.probability,
+                         i = entry.row,
+                         j = entry.col;
+
+            p_x[entry.row] += p;
+            p_y[entry.col] += p;
+            p_sum[entry.row + entry.col] += p;
+            p_difference[std::abs(int(entry.row) - int(entry.col))] += p;
+
+            asm_sum += p * p;
+            contrast += (i - j) * (i - j) * p;
+            idm += p / (1 + (i - j) * (i - j));
+            entropy -= p * std::log(p);
+            ij_sum += i * j * p;
+        }
 
-            if (a == _elements.end() or b == _elements.end())
-                return;
+        double mean_x = 0, mean_y = 0, variance_x = 0, variance_y = 0, hx = 0, hy = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            mean_x += i * p_x[i];
+            mean_y += i * p_y[i];
+        }
 
-            float a_value = 0, b_value = 0;
-            for (size_t i = 0; i < Value_t::size(); ++i)
-            {
-                a_value += a->second._value.at(i);
-                b_value += b->second._value.at(i);
-            }
+        for (size_t i = 0; i < n; ++i)
+        {
+            variance_x += (i - mean_x) * (i - mean_x) * p_x[i];
+            variance_y += (i - mean_y) * (i - mean_y) * p_y[i];
 
-            a_value = (a_value / Value_t::size()) * QUANTIZATION_N;
-            b_value = (b_value / Value_t::size()) * QUANTIZATION_N;
+            if (p_x[i] > 0)
+                hx -= p_x[i] * std::log(p_x[i]);
 
-            out(size_t(a_value), size_t(b_value)) += 1;
-            n_pairs += 1;
-        };
+            if (p_y[i] > 0)
+                hy -= p_y[i] * std::log(p_y[i]);
+        }
 
-        for (auto& pair : _elements)
+        double sum_average = 0, sum_entropy = 0;
+        for (size_t k = 0; k < p_sum.size(); ++k)
         {
-            size_t x = pair.second._position.x();
-            size_t y = pair.second._position.y();
+            sum_average += k * p_sum[k];
 
-            switch (direction)
-            {
-                case PLUS_MINUS_ZERO:
-                    process(x, y, x, y - 1);
-                    break;
-                case PLUS_45:
-                    process(x, y, x+1, y-1);
-                    break;
-                case PLUS_90:
-                    process(x, y, x+1, y);
-                    break;
-                case PLUS_125:
-                    process(x, y, x+1, y+1);
-                    break;
-                case PLUS_MINUS_180:
-                    process(x, y, x, y+1);
-                    break;
-                case MINUS_125:
-                    process(x, y, x-1, y+1);
-                    break;
-                case MINUS_90:
-                    process(x, y, x-1, y);
-                    break;
-                case MINUS_45:
-                    process(x, y, x-1, y-1);
-                    break;
-            }
+            if (p_sum[k] > 0)
+                sum_entropy -= p_sum[k] * std::log(p_sum[k]);
         }
 
-        for (size_t x = 0; x < out.rows(); ++x)
-            for (size_t y = 0; y < out.cols(); ++y)
-                out(x, y) /= float(n_pairs);
+        double sum_variance = 0;
+        for (size_t k = 0; k < p_sum.size(); ++k)
+            sum_variance += (k - sum_average) * (k - sum_average) * p_sum[k];
 
-        _co_occurrence_matrix.insert(std::make_pair(direction, out));
-        return _co_occurrence_matrix.at(direction);
+        double difference_mean = 0, difference_entropy = 0;
+        for (size_t k = 0; k < n; ++k)
+        {
+            difference_mean += k * p_difference[k];
+
+            if (p_difference[k] > 0)
+                difference_entropy -= p_difference[k] * std::log(p_difference[k]);
+        }
+
+        double difference_variance = 0;
+        for (size_t k = 0; k < n; ++k)
+            difference_variance += (k - difference_mean) * (k - difference_mean) * p_difference[k];
+
+        // HXY1 = -sum p(i, j) log(p_x(i) p_y(j)), HXY2 = -sum p_x(i) p_y(j) log(p_x(i) p_y(j)) simplifies to HX + HY
+        double hxy_1 = 0;
+        for (const auto& entry : matrix.entries)
+            hxy_1 -= entry.probability * std::log(p_x[entry.row] * p_y[entry.col]);
+
+        const double hxy_2 = hx + hy;
+
+        out.angular_second_moment = asm_sum;
+        out.contrast = contrast;
+        out.correlation = variance_x > 0 and variance_y > 0 ? (ij_sum - mean_x * mean_y) / std::sqrt(variance_x * variance_y) : 0;
+        out.sum_of_squares_variance = variance_x;
+        out.inverse_difference_moment = idm;
+        out.sum_average = sum_average;
+        out.sum_variance = sum_variance;
+        out.sum_entropy = sum_entropy;
+        out.entropy = entropy;
+        out.difference_variance = difference_variance;
+        out.difference_entropy = difference_entropy;
+        out.information_measure_of_correlation_1 = std::max(hx, hy) > 0 ? (entropy - hxy_1) / std::max(hx, hy) : 0;
+        out.information_measure_of_correlation_2 = std::sqrt(std::max(0., 1 - std::exp(-2 * (hxy_2 - entropy))));
+
+        return out;
     }
-    
+
     template<typename Image_t>
-    float ImageRegion<Image_t>::get_homogeneity(CoOccurrenceDirection direction) const
+    HaralickFeatures ImageRegion<Image_t>::get_mean_haralick_features(size_t n_levels) const
     {
-        auto& occurrence = get_co_occurrence_matrix(direction);
-        size_t sum_of_elements = occurrence.sum();
+        HaralickFeatures out;
 
+        for (size_t d = 0; d < 8; ++d)
+        {
+            auto features = get_haralick_features(CoOccurrenceDirection(d), n_levels);
+
+            out.angular_second_moment += features.angular_second_moment / 8;
+            out.contrast += features.contrast / 8;
+            out.correlation += features.correlation / 8;
+            out.sum_of_squares_variance += features.sum_of_squares_variance / 8;
+            out.inverse_difference_moment += features.inverse_difference_moment / 8;
+            out.sum_average += features.sum_average / 8;
+            out.sum_variance += features.sum_variance / 8;
+            out.sum_entropy += features.sum_entropy / 8;
+            out.entropy += features.entropy / 8;
+            out.difference_variance += features.difference_variance / 8;
+            out.difference_entropy += features.difference_entropy / 8;
+            out.information_measure_of_correlation_1 += features.information_measure_of_correlation_1 / 8;
+            out.information_measure_of_correlation_2 += features.information_measure_of_correlation_2 / 8;
+        }
+
+        return out;
+    }
+
+    template<typename Image_t>
+    float ImageRegion<Image_t>::get_homogeneity(CoOccurrenceDirection direction) const
+    {
         float sum = 0;
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-                sum += occurrence(i, j) / (1.f + fabs(float(i) - float(j)));
+        for (const auto& entry : get_co_occurrence(direction, QUANTIZATION_N).entries)
+            sum += entry.probability / (1.f + std::abs(float(entry.row) - float(entry.col)));
 
         return sum;
     }
@@ -828,94 +1335,329 @@ namespace crisp
     template<typename Image_t>
     float ImageRegion<Image_t>::get_entropy(CoOccurrenceDirection direction) const
     {
-        auto& occurrence = get_co_occurrence_matrix(direction);
-        size_t sum_of_elements = occurrence.sum();
-
         float sum = 0;
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-            {
-                if (fabs(occurrence(i, j)) < 0.0000000001)
-                    continue;
+        for (const auto& entry : get_co_occurrence(direction, QUANTIZATION_N).entries)
+            sum += entry.probability * log2(entry.probability);
 
-                std::cout << occurrence(i, j) << " * " << log2(occurrence(i, j)) << std::endl;
-                sum += occurrence(i, j) * log2(occurrence(i, j));
-            }
-
-        return (-1 * sum) / (2 * log2(256));
+        return (-1 * sum) / (2 * log2(QUANTIZATION_N));
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_contrast(CoOccurrenceDirection direction) const
     {
-        auto& occurrence = get_co_occurrence_matrix(direction);
-
-        size_t sum_of_elements = occurrence.sum();
-
         float sum = 0;
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-            {
-                sum += std::abs(int(i) - int(j)) * occurrence(i, j) / float(sum_of_elements);
-            }
+        for (const auto& entry : get_co_occurrence(direction, QUANTIZATION_N).entries)
+            sum += std::abs(int(entry.row) - int(entry.col)) * entry.probability;
 
-        return sum / (255*255);
+        return sum / ((QUANTIZATION_N - 1) * (QUANTIZATION_N - 1));
     }
 
     template<typename Image_t>
     float ImageRegion<Image_t>::get_intensity_correlation(CoOccurrenceDirection direction) const
     {
-        auto& occurrence = get_co_occurrence_matrix(direction);
-        float sum_of_elements = occurrence.sum();
-
-        float col_mean = 0;
-        float row_mean = 0;
-        float col_stddev = 0;
-        float row_stddev = 0;
+        const auto& entries = get_co_occurrence(direction, QUANTIZATION_N).entries;
 
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-                row_mean += i * (occurrence(i, j) / sum_of_elements);
+        float row_mean = 0, col_mean = 0;
+        for (const auto& entry : entries)
+        {
+            row_mean += entry.row * entry.probability;
+            col_mean += entry.col * entry.probability;
+        }
 
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-                row_stddev += (i - row_mean) * (i - row_mean) * (occurrence(i, j) / sum_of_elements);
+        float row_stddev = 0, col_stddev = 0;
+        for (const auto& entry : entries)
+        {
+            row_stddev += (entry.row - row_mean) * (entry.row - row_mean) * entry.probability;
+            col_stddev += (entry.col - col_mean) * (entry.col - col_mean) * entry.probability;
+        }
 
-        if (row_stddev == 0)
+        if (row_stddev == 0 or col_stddev == 0)
             return std::numeric_limits<float>::infinity();
 
         row_stddev = sqrt(row_stddev);
-
-        for (size_t j = 0; j < occurrence.cols(); ++j)
-            for (size_t i = 0; i < occurrence.rows(); ++i)
-                col_mean += j * (occurrence(i, j) / sum_of_elements);
-
-        for (size_t j = 0; j < occurrence.cols(); ++j)
-            for (size_t i = 0; i < occurrence.rows(); ++i)
-                col_stddev += (j - col_mean) * (j - col_mean) * (occurrence(i, j) / sum_of_elements);
-
-        if (col_stddev == 0)
-            return std::numeric_limits<float>::infinity();
-
         col_stddev = sqrt(col_stddev);
 
         float correlation = 0;
-        for (size_t i = 0; i < occurrence.rows(); ++i)
-            for (size_t j = 0; j < occurrence.cols(); ++j)
-                correlation += ((i - row_mean) * (j - col_mean) * occurrence(i, j) / sum_of_elements) / (row_stddev * col_stddev);
+        for (const auto& entry : entries)
+            correlation += ((entry.row - row_mean) * (entry.col - col_mean) * entry.probability) / (row_stddev * col_stddev);
 
         return correlation;
     }
 
+    template<typename Image_t>
+    const std::vector<Vector2ui>& ImageRegion<Image_t>::get_positions() const
+    {
+        return _positions;
+    }
+
+    template<typename Image_t>
+    const std::vector<typename ImageRegion<Image_t>::Value_t>& ImageRegion<Image_t>::get_values() const
+    {
+        return _values;
+    }
+
+    template<typename Image_t>
+    const std::vector<float>& ImageRegion<Image_t>::get_intensities() const
+    {
+        return _intensities;
+    }
+
     template<typename Image_t>
     auto ImageRegion<Image_t>::begin() const
     {
-        _elements.begin();
+        return _positions.cbegin();
     }
 
     template<typename Image_t>
     auto ImageRegion<Image_t>::end() const
     {
-        _elements.end();
+        return _positions.cend();
+    }
+
+    template<typename Image_t>
+    std::vector<RegionProperties> compute_region_properties(const Image<uint32_t, 1>& label_image, const Image_t& image)
+    {
+        using Value_t = typename Image_t::Value_t;
+
+        assert(label_image.get_size() == image.get_size());
+
+        const size_t width = label_image.get_size().x(),
+                     height = label_image.get_size().y();
+
+        const auto& labels = label_image._data;
+        const auto& data = image._data;
+
+        uint32_t max_label = 0;
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                max_label = std::max(max_label, labels(x, y).x());
+
+        const size_t n_labels = width * height > 0 ? size_t(max_label) + 1 : 0;
+
+        std::vector<RegionProperties> out(n_labels);
+        for (size_t i = 0; i < n_labels; ++i)
+            out[i].label = i;
+
+        if (n_labels == 0)
+            return out;
+
+        auto& pool = ThreadPool::get();
+
+        size_t min_stripe_height = std::max<size_t>(detail::min_region_properties_stripe_size / width, 1);
+        // each stripe accumulates into its own dense per-label vector, so cap the number of stripes for the
+        // accumulators of all stripes together to not exceed one entry per pixel
+        size_t max_n_stripes = std::max<size_t>(std::min(pool.get_n_threads() * 4, (width * height) / n_labels), 1);
+        size_t n_stripes = std::clamp<size_t>(height / min_stripe_height, 1, max_n_stripes);
+        size_t stripe_height = (height + n_stripes - 1) / n_stripes;
+        n_stripes = (height + stripe_height - 1) / stripe_height;
+
+        auto intensity = [&](size_t x, size_t y) -> double
+        {
+            const auto& value = data(x, y);
+
+            double sum = 0;
+            for (size_t i = 0; i < Value_t::size(); ++i)
+                sum += value.at(i);
+
+            return sum / Value_t::size();
+        };
+
+        // first sweep: area, bounding box and coordinate and intensity sums per stripe, then combined in stripe order
+        std::vector<std::vector<detail::RegionPropertiesSums>> stripe_sums(n_stripes);
+
+        pool.parallel_for(n_stripes, [&](size_t stripe_i)
+        {
+            auto& sums = stripe_sums[stripe_i];
+            sums.resize(n_labels);
+
+            for (size_t y = stripe_i * stripe_height; y < std::min(height, (stripe_i + 1) * stripe_height); ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    auto& current = sums[labels(x, y).x()];
+                    current.n += 1;
+                    current.min_x = std::min(current.min_x, x);
+                    current.min_y = std::min(current.min_y, y);
+                    current.max_x = std::max(current.max_x, x);
+                    current.max_y = std::max(current.max_y, y);
+                    current.x += x;
+                    current.y += y;
+                    current.intensity += intensity(x, y);
+                }
+            }
+        });
+
+        std::vector<detail::RegionPropertiesSums> sums(n_labels);
+        for (size_t stripe_i = 0; stripe_i < n_stripes; ++stripe_i)
+        {
+            for (size_t i = 0; i < n_labels; ++i)
+            {
+                const auto& from = stripe_sums[stripe_i][i];
+                auto& to = sums[i];
+
+                to.n += from.n;
+                to.min_x = std::min(to.min_x, from.min_x);
+                to.min_y = std::min(to.min_y, from.min_y);
+                to.max_x = std::max(to.max_x, from.max_x);
+                to.max_y = std::max(to.max_y, from.max_y);
+                to.x += from.x;
+                to.y += from.y;
+                to.intensity += from.intensity;
+            }
+
+            stripe_sums[stripe_i] = {};
+        }
+
+        std::vector<Vector<double, 2>> centroids(n_labels, Vector<double, 2>{0, 0});
+        std::vector<double> means(n_labels, 0);
+
+        for (size_t i = 0; i < n_labels; ++i)
+        {
+            if (sums[i].n == 0)
+                continue;
+
+            centroids[i] = Vector<double, 2>{sums[i].x / sums[i].n, sums[i].y / sums[i].n};
+            means[i] = sums[i].intensity / sums[i].n;
+        }
+
+        // second sweep: central moments around the centroid, avoids the cancellation of computing them from raw moments
+        std::vector<std::vector<detail::RegionPropertiesMoments>> stripe_moments(n_stripes);
+
+        pool.parallel_for(n_stripes, [&](size_t stripe_i)
+        {
+            auto& moments = stripe_moments[stripe_i];
+            moments.resize(n_labels);
+
+            for (size_t y = stripe_i * stripe_height; y < std::min(height, (stripe_i + 1) * stripe_height); ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const uint32_t label = labels(x, y).x();
+                    auto& current = moments[label];
+
+                    const double dx = x - centroids[label].x(),
+                                 dy = y - centroids[label].y(),
+                                 dx2 = dx * dx,
+                                 dy2 = dy * dy,
+                                 di = intensity(x, y) - means[label];
+
+                    current.mu_20 += dx2;
+                    current.mu_02 += dy2;
+                    current.mu_11 += dx * dy;
+                    current.mu_30 += dx2 * dx;
+                    current.mu_03 += dy2 * dy;
+                    current.mu_21 += dx2 * dy;
+                    current.mu_12 += dx * dy2;
+                    current.intensity_variance += di * di;
+                }
+            }
+        });
+
+        std::vector<detail::RegionPropertiesMoments> moments(n_labels);
+        for (size_t stripe_i = 0; stripe_i < n_stripes; ++stripe_i)
+        {
+            for (size_t i = 0; i < n_labels; ++i)
+            {
+                const auto& from = stripe_moments[stripe_i][i];
+                auto& to = moments[i];
+
+                to.mu_20 += from.mu_20;
+                to.mu_02 += from.mu_02;
+                to.mu_11 += from.mu_11;
+                to.mu_30 += from.mu_30;
+                to.mu_03 += from.mu_03;
+                to.mu_21 += from.mu_21;
+                to.mu_12 += from.mu_12;
+                to.intensity_variance += from.intensity_variance;
+            }
+
+            stripe_moments[stripe_i] = {};
+        }
+
+        for (size_t i = 0; i < n_labels; ++i)
+        {
+            const auto& sum = sums[i];
+            const auto& moment = moments[i];
+            auto& properties = out[i];
+
+            if (sum.n == 0)
+                continue;
+
+            const double n = sum.n;
+
+            properties.area = sum.n;
+            properties.centroid = Vector2f{float(centroids[i].x()), float(centroids[i].y())};
+            properties.min = Vector2ui{sum.min_x, sum.min_y};
+            properties.max = Vector2ui{sum.max_x, sum.max_y};
+            properties.mean = means[i];
+            properties.variance = moment.intensity_variance / n;
+
+            // eigenvalues of the coordinate covariance matrix are the variances along the major and minor axis
+            const double c_20 = moment.mu_20 / n,
+                         c_02 = moment.mu_02 / n,
+                         c_11 = moment.mu_11 / n,
+                         root = std::sqrt((c_20 - c_02) * (c_20 - c_02) + 4 * c_11 * c_11),
+                         lambda_1 = (c_20 + c_02 + root) / 2,
+                         lambda_2 = std::max((c_20 + c_02 - root) / 2, 0.);
+
+            properties.orientation = 0.5 * std::atan2(2 * c_11, c_20 - c_02);
+            properties.major_axis_length = 4 * std::sqrt(lambda_1);
+            properties.minor_axis_length = 4 * std::sqrt(lambda_2);
+            properties.eccentricity = lambda_1 > 0 ? std::sqrt(1 - lambda_2 / lambda_1) : 0;
+
+            auto eta = [&](double mu, size_t p, size_t q) {
+                return mu / std::pow(n, (p + q) / 2. + 1);
+            };
+
+            properties.hu_moments = detail::compute_hu_moments(
+                eta(moment.mu_20, 2, 0), eta(moment.mu_02, 0, 2), eta(moment.mu_11, 1, 1),
+                eta(moment.mu_30, 3, 0), eta(moment.mu_03, 0, 3), eta(moment.mu_21, 2, 1), eta(moment.mu_12, 1, 2)
+            );
+        }
+
+        return out;
+    }
+
+    inline Eigen::Matrix<float, RegionProperties::n_features, Eigen::Dynamic> to_feature_matrix(const std::vector<RegionProperties>& properties, uint32_t first_label)
+    {
+        size_t n_columns = 0;
+        for (size_t i = first_label; i < properties.size(); ++i)
+            if (properties[i].area > 0)
+                n_columns += 1;
+
+        Eigen::Matrix<float, RegionProperties::n_features, Eigen::Dynamic> out;
+        out.resize(RegionProperties::n_features, n_columns);
+
+        size_t column = 0;
+        for (size_t i = first_label; i < properties.size(); ++i)
+        {
+            const auto& region = properties[i];
+            if (region.area == 0)
+                continue;
+
+            out.col(column) <<
+                float(region.area),
+                region.centroid.x(),
+                region.centroid.y(),
+                float(region.max.x() - region.min.x() + 1),
+                float(region.max.y() - region.min.y() + 1),
+                region.orientation,
+                region.major_axis_length,
+                region.minor_axis_length,
+                region.eccentricity,
+                region.mean,
+                region.variance,
+                region.hu_moments[0],
+                region.hu_moments[1],
+                region.hu_moments[2],
+                region.hu_moments[3],
+                region.hu_moments[4],
+                region.hu_moments[5],
+                region.hu_moments[6];
+
+            column += 1;
+        }
+
+        return out;
     }
-}
\ No newline at end of file
+}
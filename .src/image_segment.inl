@@ -0,0 +1,277 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#include <algorithm>
+
+namespace crisp
+{
+    inline bool RunLengthSegment::Run::operator==(const Run& other) const
+    {
+        return y == other.y and x_begin == other.x_begin and x_end == other.x_end;
+    }
+
+    inline RunLengthSegment::RunLengthSegment(const ImageSegment& segment)
+    {
+        // sets are ordered the same way as runs so every pixel either extends the last run or starts a new one
+        for (const auto& px : segment)
+            push_back_run(px.y(), px.x(), px.x() + 1);
+    }
+
+    inline RunLengthSegment::operator ImageSegment() const
+    {
+        ImageSegment out;
+        for (const auto& run : _runs)
+            for (size_t x = run.x_begin; x < run.x_end; ++x)
+                out.emplace_hint(out.end(), Vector2ui{x, run.y});
+
+        return out;
+    }
+
+    inline void RunLengthSegment::insert(Vector2ui px)
+    {
+        insert_run(px.y(), px.x(), px.x() + 1);
+    }
+
+    inline void RunLengthSegment::push_back_run(size_t y, size_t x_begin, size_t x_end)
+    {
+        if (x_begin >= x_end)
+            return;
+
+        if (not _runs.empty() and _runs.back().y == y and x_begin <= _runs.back().x_end)
+        {
+            auto& last = _runs.back();
+            if (x_end > last.x_end)
+            {
+                _n_pixels += x_end - last.x_end;
+                last.x_end = x_end;
+            }
+        }
+        else
+        {
+            _runs.push_back(Run{y, x_begin, x_end});
+            _n_pixels += x_end - x_begin;
+        }
+    }
+
+    inline void RunLengthSegment::insert_run(size_t y, size_t x_begin, size_t x_end)
+    {
+        if (x_begin >= x_end)
+            return;
+
+        if (_runs.empty() or y > _runs.back().y or (y == _runs.back().y and x_begin >= _runs.back().x_begin))
+        {
+            push_back_run(y, x_begin, x_end);
+            return;
+        }
+
+        // first run that ends at or after x_begin in row y, all runs touching the new one follow it
+        auto first = std::lower_bound(_runs.begin(), _runs.end(), Run{y, x_begin, x_begin}, [](const Run& a, const Run& b){
+            return a.y != b.y ? a.y < b.y : a.x_end < b.x_begin;
+        });
+
+        auto last = first;
+        while (last != _runs.end() and last->y == y and last->x_begin <= x_end)
+        {
+            x_begin = std::min(x_begin, last->x_begin);
+            x_end = std::max(x_end, last->x_end);
+            _n_pixels -= last->x_end - last->x_begin;
+            ++last;
+        }
+
+        _n_pixels += x_end - x_begin;
+
+        if (first == last)
+            _runs.insert(first, Run{y, x_begin, x_end});
+        else
+        {
+            *first = Run{y, x_begin, x_end};
+            _runs.erase(first + 1, last);
+        }
+    }
+
+    inline void RunLengthSegment::clear()
+    {
+        _runs.clear();
+        _n_pixels = 0;
+    }
+
+    inline bool RunLengthSegment::contains(Vector2ui px) const
+    {
+        // last run starting at or before px
+        auto it = std::upper_bound(_runs.begin(), _runs.end(), px, [](const Vector2ui& px, const Run& run){
+            return px.y() != run.y ? px.y() < run.y : px.x() < run.x_begin;
+        });
+
+        if (it == _runs.begin())
+            return false;
+
+        --it;
+        return it->y == px.y() and px.x() < it->x_end;
+    }
+
+    inline size_t RunLengthSegment::size() const
+    {
+        return _n_pixels;
+    }
+
+    inline bool RunLengthSegment::empty() const
+    {
+        return _n_pixels == 0;
+    }
+
+    inline size_t RunLengthSegment::get_n_runs() const
+    {
+        return _runs.size();
+    }
+
+    inline const std::vector<RunLengthSegment::Run>& RunLengthSegment::get_runs() const
+    {
+        return _runs;
+    }
+
+    inline std::pair<Vector2ui, Vector2ui> RunLengthSegment::get_bounding_box() const
+    {
+        if (_runs.empty())
+            return {Vector2ui{0, 0}, Vector2ui{0, 0}};
+
+        size_t min_x = std::numeric_limits<size_t>::max(),
+               max_x = 0;
+
+        for (const auto& run : _runs)
+        {
+            min_x = std::min(min_x, run.x_begin);
+            max_x = std::max(max_x, run.x_end - 1);
+        }
+
+        return {Vector2ui{min_x, _runs.front().y}, Vector2ui{max_x, _runs.back().y}};
+    }
+
+    inline RunLengthSegment RunLengthSegment::operator|(const RunLengthSegment& other) const
+    {
+        RunLengthSegment out;
+        out._runs.reserve(_runs.size() + other._runs.size());
+
+        auto a = _runs.begin(), b = other._runs.begin();
+        while (a != _runs.end() or b != other._runs.end())
+        {
+            bool take_a = b == other._runs.end() or
+                (a != _runs.end() and (a->y != b->y ? a->y < b->y : a->x_begin < b->x_begin));
+
+            const auto& run = take_a ? *a++ : *b++;
+            out.push_back_run(run.y, run.x_begin, run.x_end);
+        }
+
+        return out;
+    }
+
+    inline RunLengthSegment RunLengthSegment::operator&(const RunLengthSegment& other) const
+    {
+        RunLengthSegment out;
+
+        auto a = _runs.begin(), b = other._runs.begin();
+        while (a != _runs.end() and b != other._runs.end())
+        {
+            if (a->y != b->y)
+            {
+                if (a->y < b->y)
+                    ++a;
+                else
+                    ++b;
+
+                continue;
+            }
+
+            out.push_back_run(a->y, std::max(a->x_begin, b->x_begin), std::min(a->x_end, b->x_end));
+
+            // advance whichever run ends first, the other one may still overlap the next run
+            if (a->x_end < b->x_end)
+                ++a;
+            else
+                ++b;
+        }
+
+        return out;
+    }
+
+    inline RunLengthSegment RunLengthSegment::operator-(const RunLengthSegment& other) const
+    {
+        RunLengthSegment out;
+
+        auto b = other._runs.begin();
+        for (const auto& a : _runs)
+        {
+            while (b != other._runs.end() and (b->y != a.y ? b->y < a.y : b->x_end <= a.x_begin))
+                ++b;
+
+            size_t current = a.x_begin;
+            for (auto it = b; it != other._runs.end() and it->y == a.y and it->x_begin < a.x_end; ++it)
+            {
+                out.push_back_run(a.y, current, it->x_begin);
+                current = std::max(current, it->x_end);
+            }
+
+            out.push_back_run(a.y, current, a.x_end);
+        }
+
+        return out;
+    }
+
+    inline bool RunLengthSegment::operator==(const RunLengthSegment& other) const
+    {
+        return _runs == other._runs;
+    }
+
+    inline bool RunLengthSegment::operator!=(const RunLengthSegment& other) const
+    {
+        return not (*this == other);
+    }
+
+    inline RunLengthSegment::ConstIterator RunLengthSegment::begin() const
+    {
+        return ConstIterator(&_runs, 0, _runs.empty() ? 0 : _runs.front().x_begin);
+    }
+
+    inline RunLengthSegment::ConstIterator RunLengthSegment::end() const
+    {
+        return ConstIterator(&_runs, _runs.size(), 0);
+    }
+
+    inline RunLengthSegment::ConstIterator::ConstIterator(const std::vector<Run>* runs, size_t run_i, size_t x)
+        : _runs(runs), _run_i(run_i), _x(x)
+    {}
+
+    inline bool RunLengthSegment::ConstIterator::operator==(const ConstIterator& other) const
+    {
+        return _runs == other._runs and _run_i == other._run_i and _x == other._x;
+    }
+
+    inline bool RunLengthSegment::ConstIterator::operator!=(const ConstIterator& other) const
+    {
+        return not (*this == other);
+    }
+
+    inline RunLengthSegment::ConstIterator& RunLengthSegment::ConstIterator::operator++()
+    {
+        if (++_x == (*_runs)[_run_i].x_end)
+        {
+            ++_run_i;
+            _x = _run_i < _runs->size() ? (*_runs)[_run_i].x_begin : 0;
+        }
+
+        return *this;
+    }
+
+    inline RunLengthSegment::ConstIterator RunLengthSegment::ConstIterator::operator++(int)
+    {
+        auto out = *this;
+        ++(*this);
+        return out;
+    }
+
+    inline Vector2ui RunLengthSegment::ConstIterator::operator*() const
+    {
+        return Vector2ui{_x, (*_runs)[_run_i].y};
+    }
+}
@@ -6,21 +6,28 @@
 #include <gpu_side/texture.hpp>
 #include <gpu_side/state.hpp>
 
+#include <array>
+#include <memory>
+#include <algorithm>
+
 namespace crisp
 {
     void MorphologicalTransform::set_structuring_element(StructuringElement se)
     {
         _origin = Vector2ui{size_t(se.rows()) / 2, size_t(se.cols()) / 2};
         _structuring_element = std::move(se);
+        compile_structuring_element();
     }
 
     StructuringElement& MorphologicalTransform::get_structuring_element()
     {
+        _offsets_up_to_date = false;
         return _structuring_element;
     }
 
     std::optional<bool>& MorphologicalTransform::operator()(size_t x, size_t y)
     {
+        _offsets_up_to_date = false;
         return _structuring_element(x, y);
     }
 
@@ -32,6 +39,7 @@ namespace crisp
     void MorphologicalTransform::set_structuring_element_origin(size_t x, size_t y)
     {
         _origin = Vector2ui{x, y};
+        _offsets_up_to_date = false;
     }
 
     Vector2ui MorphologicalTransform::get_structuring_element_origin() const
@@ -39,150 +47,147 @@ namespace crisp
         return _origin;
     }
 
-    template<typename Image_t>
-    void MorphologicalTransform::erode_aux(Image_t& img_in, Image_t& img_out)
+    void MorphologicalTransform::compile_structuring_element()
     {
+        _foreground_offsets.clear();
+        _background_offsets.clear();
+
         const auto& se = _structuring_element;
 
-        int n = se.rows(),
-            m = se.cols();
+        // eigen matrices are column-major, iterating columns in the outer loop yields offsets sorted by (y, x)
+        for (long b = 0; b < se.cols(); ++b)
+        {
+            for (long a = 0; a < se.rows(); ++a)
+            {
+                if (not se(a, b).has_value())
+                    continue;
+
+                auto offset = Vector2i{int(a) - int(_origin.x()), int(b) - int(_origin.y())};
 
-        auto origin = Vector2i{int(_origin.x()), int(_origin.y())};
+                if (se(a, b).value())
+                    _foreground_offsets.push_back(offset);
+                else
+                    _background_offsets.push_back(offset);
+            }
+        }
+
+        _offsets_up_to_date = true;
+    }
+
+    template<bool Erode, typename Image_t>
+    void MorphologicalTransform::erode_or_dilate_aux(const Image_t& img_in, Image_t& img_out)
+    {
+        if (not _offsets_up_to_date)
+            compile_structuring_element();
 
         using ImageValue_t = typename Image_t::Value_t;
         using Inner_t = typename Image_t::Value_t::Value_t;
 
-        for (int y = 0; y < img_in.get_size().y(); ++y)
+        const long width = img_in.get_size().x(),
+                   height = img_in.get_size().y();
+
+        // pixels whose whole neighborhood lies inside the image read the column-major array directly through
+        // precomputed linear offsets, all other pixels go through the images padding
+        long min_dx = 0, max_dx = 0, min_dy = 0, max_dy = 0;
+        std::vector<long> linear_offsets;
+        linear_offsets.reserve(_foreground_offsets.size());
+
+        for (const auto& offset : _foreground_offsets)
         {
-            for (int x = 0; x < img_in.get_size().x(); ++x)
-            {
-                ImageValue_t out = img_in(x, y);
+            min_dx = std::min<long>(min_dx, offset.x());
+            max_dx = std::max<long>(max_dx, offset.x());
+            min_dy = std::min<long>(min_dy, offset.y());
+            max_dy = std::max<long>(max_dy, offset.y());
+            linear_offsets.push_back(offset.x() + offset.y() * width);
+        }
+
+        const size_t n = _foreground_offsets.size();
 
-                // binary
-                if (std::is_same_v<Inner_t, bool>)
+        auto apply = [&](long x, long y, auto&& neighbor) -> ImageValue_t
+        {
+            // binary dilation does not include the pixel itself unless the origin is foreground
+            ImageValue_t out;
+            if constexpr (Erode or not std::is_same_v<Inner_t, bool>)
+                out = img_in._data(x, y);
+
+            for (size_t i = 0; i < ImageValue_t::size(); ++i)
+            {
+                if constexpr (std::is_same_v<Inner_t, bool>)
                 {
-                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
+                    // binary: exit on first element that misses (erosion) or hits (dilation)
+                    for (size_t k = 0; k < n; ++k)
                     {
-                        bool missed = false;
-                        for (int a = 0; a < n; ++a)
+                        if (neighbor(k).at(i) != Erode)
                         {
-                            for (int b = 0; b < m; ++b)
-                            {
-                                if (not se(a, b).has_value())
-                                    continue;
-
-                                if (se(a, b) and not img_in(x + a - origin.x(), y + b - origin.y()).at(i))
-                                {
-                                    missed = true;
-                                    goto skip;
-                                }
-                            }
+                            out.at(i) = not Erode;
+                            break;
                         }
-
-                        skip:
-                        if (missed)
-                            out.at(i) = false;
                     }
                 }
                 else
                 {
-                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
-                    {
-                        auto min = img_in(x, y).at(i);
-                        for (int a = 0; a < n; ++a)
-                        {
-                            for (int b = 0; b < m ; ++b)
-                            {
-                                if (not se(a, b).has_value())
-                                    continue;
-
-                                if (se(a, b))
-                                {
-                                    min = std::min(img_in(x + a - origin.x(), y + b - origin.y()).at(i), min);
-                                }
-                            }
-                        }
+                    auto current = out.at(i);
+                    for (size_t k = 0; k < n; ++k)
+                        current = Erode ? std::min(neighbor(k).at(i), current) : std::max(neighbor(k).at(i), current);
 
-                        out.at(i) = min;
-                    }
+                    out.at(i) = current;
                 }
-
-                img_out(x, y) = out;
             }
-        }
-    }
-
-    template<typename Image_t>
-    void MorphologicalTransform::dilate_aux(Image_t& img_in, Image_t& img_out)
-    {
-        const auto& se = _structuring_element;
 
-        int n = se.rows(),
-            m = se.cols();
+            return out;
+        };
 
-        auto origin = Vector2i{int(_origin.x()), int(_origin.y())};
-
-        using ImageValue_t = typename Image_t::Value_t;
-        using Inner_t = typename Image_t::Value_t::Value_t;
+        const ImageValue_t* data = img_in._data.data();
 
-        for (int y = 0; y < img_in.get_size().y(); ++y)
+        ThreadPool::get().parallel_for_tiles(width, height, [&](long x_begin, long x_end, long y_begin, long y_end)
         {
-            for (int x = 0; x < img_in.get_size().x(); ++x)
+            const long x_interior_begin = std::clamp(-min_dx, x_begin, x_end),
+                       x_interior_end = std::clamp(width - max_dx, x_interior_begin, x_end);
+
+            for (long y = y_begin; y < y_end; ++y)
             {
-                ImageValue_t out;
+                auto padded = [&](long x, long y)
+                {
+                    img_out._data(x, y) = apply(x, y, [&](size_t k) {
+                        return img_in.get_pixel_or_padding(x + _foreground_offsets[k].x(), y + _foreground_offsets[k].y());
+                    });
+                };
 
-                // binary
-                if (std::is_same_v<Inner_t, bool>)
+                if (y + min_dy < 0 or y + max_dy >= height)
                 {
-                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
-                    {
-                        bool found = false;
-                        for (int a = 0; a < n; ++a)
-                        {
-                            for (int b = 0; b < m; ++b)
-                            {
-                                if (not se(a, b).has_value())
-                                    continue;
-
-                                if (se(a, b) and img_in(x + a - origin.x(), y + b - origin.x()).at(i))
-                                {
-                                    found = true;
-                                    goto skip;
-                                }
-                            }
-                        }
+                    for (long x = x_begin; x < x_end; ++x)
+                        padded(x, y);
 
-                        skip:
-                        if (found)
-                            out.at(i) = true;
-                    }
+                    continue;
                 }
-                else
-                {
-                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
-                    {
-                        auto max = img_in(x, y).at(i);
-                        for (int a = 0; a < n; ++a)
-                        {
-                            for (int b = 0; b < m; ++b)
-                            {
-                                if (not se(a, b).has_value())
-                                    continue;
-
-                                if (se(a, b))
-                                {
-                                    max = std::max(img_in(x + a - origin.x(), y + b - origin.x()).at(i), max);
-                                }
-                            }
-                        }
 
-                        out.at(i) = max;
-                    }
+                for (long x = x_begin; x < x_interior_begin; ++x)
+                    padded(x, y);
+
+                for (long x = x_interior_begin; x < x_interior_end; ++x)
+                {
+                    const ImageValue_t* center = data + x + y * width;
+                    img_out._data(x, y) = apply(x, y, [&](size_t k) -> const ImageValue_t& {
+                        return center[linear_offsets[k]];
+                    });
                 }
 
-                img_out(x, y) = out;
+                for (long x = x_interior_end; x < x_end; ++x)
+                    padded(x, y);
             }
-        }
+        }, TILE_WIDTH, TILE_HEIGHT);
+    }
+
+    template<typename Image_t>
+    void MorphologicalTransform::erode_aux(const Image_t& img_in, Image_t& img_out)
+    {
+        erode_or_dilate_aux<true>(img_in, img_out);
+    }
+
+    template<typename Image_t>
+    void MorphologicalTransform::dilate_aux(const Image_t& img_in, Image_t& img_out)
+    {
+        erode_or_dilate_aux<false>(img_in, img_out);
     }
 
     template<typename Image_t>
@@ -192,10 +197,7 @@ namespace crisp
         result.create(image.get_size().x(), image.get_size().y());
 
         erode_aux(image, result);
-
-        for (long x = 0; x < image.get_size().x(); ++x)
-            for (long y = 0; y < image.get_size().x(); ++y)
-                image(x, y) = result(x, y);
+        image._data.swap(result._data);
     }
 
     template<typename T, size_t N>
@@ -234,10 +236,7 @@ namespace crisp
         result.create(image.get_size().x(), image.get_size().y());
 
         dilate_aux(image, result);
-
-        for (long x = 0; x < image.get_size().x(); ++x)
-            for (long y = 0; y < image.get_size().x(); ++y)
-                image(x, y) = result(x, y);
+        image._data.swap(result._data);
     }
 
     template<typename T, size_t N>
@@ -279,14 +278,17 @@ namespace crisp
 
         erode_aux(image, result);
 
-        for (long x = 0; x < image.get_size().x(); ++x)
+        ThreadPool::get().parallel_for_tiles(image.get_size().x(), image.get_size().y(), [&](size_t x_begin, size_t x_end, size_t y_begin, size_t y_end)
         {
-            for (long y = 0; y < image.get_size().x(); ++y)
+            for (size_t y = y_begin; y < y_end; ++y)
             {
-                if (mask(x, y) <= image(x, y))
-                    image(x, y) = std::max(result(x, y), mask(x, y));
+                for (size_t x = x_begin; x < x_end; ++x)
+                {
+                    if (mask._data(x, y) <= image._data(x, y))
+                        image._data(x, y) = std::max(result._data(x, y), mask._data(x, y));
+                }
             }
-        }
+        }, TILE_WIDTH, TILE_HEIGHT);
     }
 
     template<typename T, size_t N>
@@ -342,14 +344,19 @@ namespace crisp
 
         dilate_aux(image, result);
 
-        for (long x = 0; x < image.get_size().x(); ++x)
-            for (long y = 0; y < image.get_size().x(); ++y)
+        ThreadPool::get().parallel_for_tiles(image.get_size().x(), image.get_size().y(), [&](size_t x_begin, size_t x_end, size_t y_begin, size_t y_end)
+        {
+            for (size_t y = y_begin; y < y_end; ++y)
             {
-                if (image(x, y) == result(x, y))
-                    continue;
-                else
-                    image(x, y) = std::min(result(x, y), mask(x, y));
+                for (size_t x = x_begin; x < x_end; ++x)
+                {
+                    if (image._data(x, y) == result._data(x, y))
+                        continue;
+                    else
+                        image._data(x, y) = std::min(result._data(x, y), mask._data(x, y));
+                }
             }
+        }, TILE_WIDTH, TILE_HEIGHT);
     }
 
     template<typename T, size_t N>
@@ -493,6 +500,122 @@ namespace crisp
         State::free_matrix(se);
     }
 
+    template<typename Image_t>
+    Granulometry<Image_t> MorphologicalTransform::granulometry(const Image_t& image, size_t n_scales, bool compute_top_hats)
+    {
+        if (not _offsets_up_to_date)
+            compile_structuring_element();
+
+        using ImageValue_t = typename Image_t::Value_t;
+        using Inner_t = typename Image_t::Value_t::Value_t;
+
+        const auto width = image.get_size().x(),
+                   height = image.get_size().y();
+
+        auto volume = [&](const Image_t& in) -> double
+        {
+            double sum = 0;
+            for (size_t y = 0; y < height; ++y)
+                for (size_t x = 0; x < width; ++x)
+                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
+                        sum += double(in(x, y).at(i));
+
+            return sum;
+        };
+
+        // opening by nB is erosion by B n times followed by dilation by B n times. The erosions form a chain where
+        // each scale is built from the previous one, the dilations of each scale are independent of each other
+        std::vector<Image_t> eroded;
+        eroded.reserve(n_scales);
+
+        for (size_t n = 0; n < n_scales; ++n)
+        {
+            eroded.emplace_back();
+            eroded.back().create(width, height);
+            eroded.back().set_padding_type(image.get_padding_type());
+            erode_aux(n == 0 ? image : eroded.at(n - 1), eroded.back());
+        }
+
+        // scratch buffers are handed out to whichever thread processes a scale and reused for all later scales
+        std::vector<std::unique_ptr<std::array<Image_t, 2>>> scratch;
+        std::mutex scratch_mutex;
+
+        auto acquire_scratch = [&]() -> std::unique_ptr<std::array<Image_t, 2>>
+        {
+            {
+                auto lock = std::lock_guard(scratch_mutex);
+                if (not scratch.empty())
+                {
+                    auto out = std::move(scratch.back());
+                    scratch.pop_back();
+                    return out;
+                }
+            }
+
+            auto out = std::make_unique<std::array<Image_t, 2>>();
+            for (auto& buffer : *out)
+            {
+                buffer.create(width, height);
+                buffer.set_padding_type(image.get_padding_type());
+            }
+
+            return out;
+        };
+
+        std::vector<double> volumes(n_scales + 1);
+        volumes.at(0) = volume(image);
+
+        Granulometry<Image_t> out;
+        if (compute_top_hats)
+            out.top_hats.resize(n_scales);
+
+        // largest scales first, they need the most dilations
+        ThreadPool::get().parallel_for(n_scales, [&](size_t i)
+        {
+            size_t n = n_scales - 1 - i;
+            auto buffers = acquire_scratch();
+
+            Image_t* current = &eroded.at(n);
+            for (size_t k = 0; k <= n; ++k)
+            {
+                Image_t* next = &buffers->at(k % 2);
+                dilate_aux(*current, *next);
+                current = next;
+            }
+
+            volumes.at(n + 1) = volume(*current);
+
+            if (compute_top_hats)
+            {
+                auto& top_hat = out.top_hats.at(n);
+                top_hat.create(width, height);
+
+                for (size_t y = 0; y < height; ++y)
+                {
+                    for (size_t x = 0; x < width; ++x)
+                    {
+                        for (size_t j = 0; j < ImageValue_t::size(); ++j)
+                        {
+                            if constexpr (std::is_same_v<Inner_t, bool>)
+                                top_hat(x, y).at(j) = image(x, y).at(j) and not (*current)(x, y).at(j);
+                            else
+                                top_hat(x, y).at(j) = image(x, y).at(j) - (*current)(x, y).at(j);
+                        }
+                    }
+                }
+            }
+
+            auto lock = std::lock_guard(scratch_mutex);
+            scratch.push_back(std::move(buffers));
+        });
+
+        out.pattern_spectrum.reserve(n_scales);
+        for (size_t n = 0; n < n_scales; ++n)
+            out.pattern_spectrum.push_back(volumes.at(n) - volumes.at(n + 1));
+
+        return out;
+    }
+
     StructuringElement MorphologicalTransform::all_dont_care(long nrows, long ncols)
     {
         StructuringElement out;
@@ -593,10 +716,8 @@ namespace crisp
     template<typename Image_t>
     void MorphologicalTransform::hit_or_miss_transform(Image_t& image)
     {
-        long n = _structuring_element.rows(),
-             m = _structuring_element.cols();
-
-        auto origin = Vector2i{int(_origin.x()), int(_origin.y())};
+        if (not _offsets_up_to_date)
+            compile_structuring_element();
 
         Image_t result;
 
@@ -605,37 +726,29 @@ namespace crisp
 
         result.create(image.get_size().x(), image.get_size().y(), ImageValue_t(Inner_t(0)));
 
-        for (long x = 0; x < image.get_size().x(); ++x)
+        // pattern matches if all foreground elements hit 1 and all background elements hit 0, exit on first miss
+        auto matches = [&](long x, long y, size_t i) -> bool
         {
-            for (long y = 0; y < image.get_size().y(); ++y)
-            {
-                for (size_t i = 0; i < ImageValue_t::size(); ++i)
-                {
-                    bool found = true;
-                    for (int a = -origin.x(); a < n - origin.x(); ++a)
-                    {
-                        for (int b = -origin.y(); b < m - origin.y(); ++b)
-                        {
-                            if (not _structuring_element(a + origin.x(), b + origin.y()).has_value())
-                                continue;
-
-                            if (image(x + a, y + b).at(i) != Inner_t(_structuring_element(a + origin.x(), b + origin.y()).value()))
-                            {
-                                found = false;
-                                goto no_hit;
-                            }
-                        }
-                    }
+            for (const auto& offset : _foreground_offsets)
+                if (image.get_pixel_or_padding(x + offset.x(), y + offset.y()).at(i) != Inner_t(true))
+                    return false;
 
-                    no_hit:
-                    result(x, y).at(i) = Inner_t(found);
-                }
-            }
-        }
+            for (const auto& offset : _background_offsets)
+                if (image.get_pixel_or_padding(x + offset.x(), y + offset.y()).at(i) != Inner_t(false))
+                    return false;
 
-        for (long i = 0; i < image.get_size().x(); ++i)
-            for (long j = 0; j < image.get_size().y(); ++j)
-                image(i, j) = result(i, j);
+            return true;
+        };
+
+        ThreadPool::get().parallel_for_tiles(image.get_size().x(), image.get_size().y(), [&](size_t x_begin, size_t x_end, size_t y_begin, size_t y_end)
+        {
+            for (size_t y = y_begin; y < y_end; ++y)
+                for (size_t x = x_begin; x < x_end; ++x)
+                    for (size_t i = 0; i < ImageValue_t::size(); ++i)
+                        result._data(x, y).at(i) = Inner_t(matches(x, y, i));
+        }, TILE_WIDTH, TILE_HEIGHT);
+
+        image._data.swap(result._data);
     }
 
     template<typename Image_t>
@@ -643,8 +756,8 @@ namespace crisp
     {
         assert(_structuring_element.rows() == replacement.rows() and _structuring_element.cols() == replacement.cols());
 
-        long n = _structuring_element.rows(),
-             m = _structuring_element.cols();
+        if (not _offsets_up_to_date)
+            compile_structuring_element();
 
         auto origin = Vector2i{int(_origin.x()), int(_origin.y())};
 
@@ -653,46 +766,41 @@ namespace crisp
         using ImageValue_t = typename Image_t::Value_t;
         using Inner_t = typename Image_t::Value_t::Value_t;
 
-        for (long x = 0; x < image.get_size().x(); ++x)
+        auto matches = [&](long x, long y, size_t i) -> bool
         {
-            for (long y = 0; y < image.get_size().y(); ++y)
-            {
-                for (size_t i = 0; i < ImageValue_t::size(); ++i)
-                {
-                    for (int a = -origin.x(); a < n - origin.x(); ++a)
-                    {
-                        for (int b = -origin.y(); b < m - origin.y(); ++b)
-                        {
-                            if (not _structuring_element(a + origin.x(), b + origin.y()).has_value())
-                                continue;
+            for (const auto& offset : _foreground_offsets)
+                if (image(x + offset.x(), y + offset.y()).at(i) != Inner_t(true))
+                    return false;
 
-                            if (image(x + a, y + b).at(i) != Inner_t(_structuring_element(a + origin.x(), b + origin.y()).value()))
-                            {
-                                goto next;
-                            }
-                        }
-                    }
+            for (const auto& offset : _background_offsets)
+                if (image(x + offset.x(), y + offset.y()).at(i) != Inner_t(false))
+                    return false;
 
-                    // found
-                    for (int a = -origin.x(); a < n - origin.x(); ++a)
-                    {
-                        for (int b = -origin.y(); b < m - origin.y(); ++b)
-                        {
-                            if (not _structuring_element(a + origin.x(), b + origin.y()).has_value())
-                                continue;
+            return true;
+        };
 
-                            result(x + a, y + b).at(i) = replacement(a + origin.x(), b + origin.y()).value_or(false);
-                        }
-                    }
+        auto replace = [&](long x, long y, size_t i, const std::vector<Vector2i>& offsets)
+        {
+            for (const auto& offset : offsets)
+                result(x + offset.x(), y + offset.y()).at(i) = replacement(offset.x() + origin.x(), offset.y() + origin.y()).value_or(false);
+        };
+
+        for (long y = 0; y < image.get_size().y(); ++y)
+        {
+            for (long x = 0; x < image.get_size().x(); ++x)
+            {
+                for (size_t i = 0; i < ImageValue_t::size(); ++i)
+                {
+                    if (not matches(x, y, i))
+                        continue;
 
-                    next:;
+                    replace(x, y, i, _foreground_offsets);
+                    replace(x, y, i, _background_offsets);
                 }
             }
         }
 
-        for (long i = 0; i < image.get_size().x(); ++i)
-            for (long j = 0; j < image.get_size().y(); ++j)
-                image(i, j) = result(i, j);
+        image._data.swap(result._data);
     }
 
     NonFlatStructuringElement MorphologicalTransform::square_pyramid(long dimensions)
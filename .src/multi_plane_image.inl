@@ -42,6 +42,9 @@ namespace crisp
     {
         assert(not (x >= 0 and x < _data.rows() and y >= 0 and y < _data.cols()));
 
+        const int width = _data.rows(),
+                  height = _data.cols();
+
         switch (_padding_type)
         {
             case ZERO:
@@ -50,30 +53,30 @@ namespace crisp
                 return Value_t(InnerValue_t(1));
             case REPEAT:
             {
-                int x_mod = x % int(get_size().x());
-                int y_mod = y % int(get_size().y());
+                int x_mod = x % width;
+                int y_mod = y % height;
 
                 if (x_mod < 0)
-                    x_mod += get_size().x();
+                    x_mod += width;
 
                 if (y_mod < 0)
-                    y_mod += get_size().y();
+                    y_mod += height;
 
                 return at(x_mod, y_mod);
             }
             case MIRROR:
             {
-                int new_x = x % (get_size().x() - 1);
+                int new_x = x % std::max(width - 1, 1);
                 if (x < 0)
                     new_x = abs(new_x);
-                else if (x >= get_size().x())
-                    new_x = get_size().x() - 1 - new_x;
+                else if (x >= width)
+                    new_x = width - 1 - new_x;
 
-                int new_y = y % (get_size().y() - 1);
+                int new_y = y % std::max(height - 1, 1);
                 if (y < 0)
                     new_y = abs(new_y);
-                else if (y >= get_size().y())
-                    new_y = get_size().y() - 1 - new_y;
+                else if (y >= height)
+                    new_y = height - 1 - new_y;
 
                 return at(new_x, new_y);
             }
@@ -82,14 +85,14 @@ namespace crisp
                 int new_x = x;
                 if (x < 0)
                     new_x = 0;
-                if (x >= get_size().x())
-                    new_x = get_size().x() - 1;
+                if (x >= width)
+                    new_x = width - 1;
 
                 int new_y = y;
                 if (y < 0)
                     new_y = 0;
-                if (y >= get_size().y())
-                    new_y = get_size().y() - 1;
+                if (y >= height)
+                    new_y = height - 1;
 
                 return at(new_x, new_y);
             }
@@ -98,6 +101,15 @@ namespace crisp
         }
     }
 
+    template<typename InnerValue_t, size_t N>
+    typename Image<InnerValue_t, N>::Value_t Image<InnerValue_t, N>::get_pixel_or_padding(int x, int y) const
+    {
+        if (x < 0 or x >= _data.rows() or y < 0 or y >= _data.cols())
+            return get_pixel_out_of_bounds(x, y);
+        else
+            return _data(x, y);
+    }
+
     template<typename InnerValue_t, size_t N>
     const typename Image<InnerValue_t, N>::Value_t& Image<InnerValue_t, N>::operator()(int x, int y) const
     {
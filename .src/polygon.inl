@@ -0,0 +1,378 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <tuple>
+
+namespace crisp
+{
+    namespace detail
+    {
+        using PolygonPoint = std::array<double, 2>;
+
+        template<typename T>
+        std::vector<PolygonPoint> to_polygon_points(const std::vector<Vector<T, 2>>& points)
+        {
+            std::vector<PolygonPoint> out;
+            out.reserve(points.size());
+
+            for (const auto& point : points)
+                out.push_back({double(point.x()), double(point.y())});
+
+            return out;
+        }
+
+        // z-component of (a - o) x (b - o), positive if o, a, b turn counter-clockwise in a y-up coordinate system
+        inline double cross(const PolygonPoint& o, const PolygonPoint& a, const PolygonPoint& b)
+        {
+            return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+        }
+
+        // distance of p to the line through a and b, or to a if both are the same point
+        inline double distance_to_line(const PolygonPoint& p, const PolygonPoint& a, const PolygonPoint& b)
+        {
+            double length = std::hypot(b[0] - a[0], b[1] - a[1]);
+
+            if (length == 0)
+                return std::hypot(p[0] - a[0], p[1] - a[1]);
+
+            return std::abs(cross(a, b, p)) / length;
+        }
+
+        // indices of the hull vertices, with positive signed area, so clockwise if y points down
+        inline std::vector<size_t> convex_hull_indices(const std::vector<PolygonPoint>& points)
+        {
+            std::vector<size_t> sorted(points.size());
+            for (size_t i = 0; i < sorted.size(); ++i)
+                sorted[i] = i;
+
+            std::sort(sorted.begin(), sorted.end(), [&](size_t a, size_t b){
+                return points[a] < points[b];
+            });
+
+            sorted.erase(std::unique(sorted.begin(), sorted.end(), [&](size_t a, size_t b){
+                return points[a] == points[b];
+            }), sorted.end());
+
+            if (sorted.size() <= 2)
+                return sorted;
+
+            std::vector<size_t> hull(2 * sorted.size());
+            size_t k = 0;
+
+            // lower hull, then upper hull, dropping every vertex that does not turn left
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                while (k >= 2 and cross(points[hull[k-2]], points[hull[k-1]], points[sorted[i]]) <= 0)
+                    --k;
+
+                hull[k++] = sorted[i];
+            }
+
+            for (size_t i = sorted.size() - 1, lower_size = k + 1; i-- > 0;)
+            {
+                while (k >= lower_size and cross(points[hull[k-2]], points[hull[k-1]], points[sorted[i]]) <= 0)
+                    --k;
+
+                hull[k++] = sorted[i];
+            }
+
+            // last vertex is the first one
+            hull.resize(k - 1);
+            return hull;
+        }
+    }
+
+    template<typename T>
+    std::vector<Vector<T, 2>> simplify_polygon(const std::vector<Vector<T, 2>>& polygon, float tolerance, PolygonSimplification algorithm)
+    {
+        const size_t n = polygon.size();
+        if (n <= 3)
+            return polygon;
+
+        auto points = detail::to_polygon_points(polygon);
+        std::vector<bool> keep(n, algorithm == PolygonSimplification::VISVALINGAM_WHYATT);
+
+        if (algorithm == PolygonSimplification::DOUGLAS_PEUCKER)
+        {
+            // split the closed polygon at the first vertex and the vertex farthest from it
+            size_t farthest = 0;
+            double max_distance = -1;
+            for (size_t i = 1; i < n; ++i)
+            {
+                double distance = std::hypot(points[i][0] - points[0][0], points[i][1] - points[0][1]);
+                if (distance > max_distance)
+                {
+                    max_distance = distance;
+                    farthest = i;
+                }
+            }
+
+            keep[0] = true;
+            keep[farthest] = true;
+
+            // ranges [first, last] of indices, where last == n is the first vertex
+            std::vector<std::pair<size_t, size_t>> stack = {{0, farthest}, {farthest, n}};
+            while (not stack.empty())
+            {
+                auto [first, last] = stack.back();
+                stack.pop_back();
+
+                if (last - first < 2)
+                    continue;
+
+                size_t deepest = first;
+                double depth = -1;
+                for (size_t i = first + 1; i < last; ++i)
+                {
+                    double distance = detail::distance_to_line(points[i], points[first], points[last % n]);
+                    if (distance > depth)
+                    {
+                        depth = distance;
+                        deepest = i;
+                    }
+                }
+
+                if (depth > tolerance)
+                {
+                    keep[deepest] = true;
+                    stack.push_back({first, deepest});
+                    stack.push_back({deepest, last});
+                }
+            }
+        }
+        else if (algorithm == PolygonSimplification::VISVALINGAM_WHYATT)
+        {
+            std::vector<size_t> previous(n), next(n), version(n, 0);
+            for (size_t i = 0; i < n; ++i)
+            {
+                previous[i] = (i + n - 1) % n;
+                next[i] = (i + 1) % n;
+            }
+
+            auto area = [&](size_t i) -> double {
+                return std::abs(detail::cross(points[previous[i]], points[i], points[next[i]])) / 2;
+            };
+
+            // min-heap of (area, vertex, version), entries of vertices whose neighbors changed since are stale
+            using Entry = std::tuple<double, size_t, size_t>;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+
+            for (size_t i = 0; i < n; ++i)
+                queue.push({area(i), i, 0});
+
+            size_t n_remaining = n;
+            while (not queue.empty() and n_remaining > 3)
+            {
+                auto [current_area, i, current_version] = queue.top();
+                queue.pop();
+
+                if (not keep[i] or current_version != version[i])
+                    continue;
+
+                if (current_area >= tolerance)
+                    break;
+
+                keep[i] = false;
+                n_remaining -= 1;
+
+                next[previous[i]] = next[i];
+                previous[next[i]] = previous[i];
+
+                for (size_t neighbor : {previous[i], next[i]})
+                    queue.push({area(neighbor), neighbor, ++version[neighbor]});
+            }
+        }
+
+        std::vector<Vector<T, 2>> out;
+        for (size_t i = 0; i < n; ++i)
+            if (keep[i])
+                out.push_back(polygon[i]);
+
+        return out;
+    }
+
+    template<typename T>
+    std::vector<Vector<T, 2>> convex_hull(const std::vector<Vector<T, 2>>& points)
+    {
+        auto hull = detail::convex_hull_indices(detail::to_polygon_points(points));
+
+        // y points down, so reversing makes the hull counter-clockwise on screen
+        std::vector<Vector<T, 2>> out;
+        out.reserve(hull.size());
+
+        for (auto it = hull.rbegin(); it != hull.rend(); ++it)
+            out.push_back(points[*it]);
+
+        return out;
+    }
+
+    template<typename T>
+    float polygon_area(const std::vector<Vector<T, 2>>& polygon)
+    {
+        auto points = detail::to_polygon_points(polygon);
+
+        double sum = 0;
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& a = points[i];
+            const auto& b = points[(i + 1) % points.size()];
+            sum += a[0] * b[1] - b[0] * a[1];
+        }
+
+        return std::abs(sum) / 2;
+    }
+
+    template<typename T>
+    std::vector<ConvexityDefect> convexity_defects(const std::vector<Vector<T, 2>>& polygon, float min_depth)
+    {
+        const size_t n = polygon.size();
+        auto points = detail::to_polygon_points(polygon);
+        auto hull = detail::convex_hull_indices(points);
+
+        if (hull.size() < 3)
+            return {};
+
+        // hull vertices in the order they appear along the polygon, each stretch of polygon between two of them is a candidate
+        std::sort(hull.begin(), hull.end());
+
+        std::vector<ConvexityDefect> out;
+        for (size_t i = 0; i < hull.size(); ++i)
+        {
+            size_t begin = hull[i],
+                   end = hull[(i + 1) % hull.size()];
+
+            size_t last = end > begin ? end : end + n;
+
+            size_t deepest = begin;
+            double depth = 0;
+            for (size_t j = begin + 1; j < last; ++j)
+            {
+                double distance = detail::distance_to_line(points[j % n], points[begin], points[end]);
+                if (distance > depth)
+                {
+                    depth = distance;
+                    deepest = j % n;
+                }
+            }
+
+            if (depth > min_depth)
+                out.push_back(ConvexityDefect{begin, end, deepest, float(depth)});
+        }
+
+        return out;
+    }
+
+    inline std::array<Vector2f, 4> RotatedRectangle::get_corners() const
+    {
+        float half_width = size.x() / 2,
+              half_height = size.y() / 2;
+
+        Vector2f u = Vector2f{std::cos(angle) * half_width, std::sin(angle) * half_width},
+                 v = Vector2f{-std::sin(angle) * half_height, std::cos(angle) * half_height};
+
+        return {center - u - v, center + u - v, center + u + v, center - u + v};
+    }
+
+    inline float RotatedRectangle::get_area() const
+    {
+        return size.x() * size.y();
+    }
+
+    template<typename T>
+    RotatedRectangle minimum_area_rectangle(const std::vector<Vector<T, 2>>& points_in)
+    {
+        auto points = detail::to_polygon_points(points_in);
+        auto hull_indices = detail::convex_hull_indices(points);
+
+        std::vector<detail::PolygonPoint> hull;
+        hull.reserve(hull_indices.size());
+        for (size_t i : hull_indices)
+            hull.push_back(points[i]);
+
+        const size_t n = hull.size();
+        RotatedRectangle out;
+
+        if (n == 0)
+            return out;
+
+        if (n == 1)
+        {
+            out.center = Vector2f{float(hull[0][0]), float(hull[0][1])};
+            return out;
+        }
+
+        if (n == 2)
+        {
+            out.center = Vector2f{float(hull[0][0] + hull[1][0]) / 2, float(hull[0][1] + hull[1][1]) / 2};
+            out.size = Vector2f{float(std::hypot(hull[1][0] - hull[0][0], hull[1][1] - hull[0][1])), 0};
+            out.angle = std::atan2(hull[1][1] - hull[0][1], hull[1][0] - hull[0][0]);
+            return out;
+        }
+
+        // for each hull edge, the vertices with maximum and minimum projection onto the edge and maximum distance from it
+        // only ever move forward along the hull, so each of them visits every vertex at most twice
+        size_t right = 0, top = 0, left = 0;
+        double min_area = std::numeric_limits<double>::max();
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const auto& origin = hull[i];
+            const auto& other = hull[(i + 1) % n];
+
+            double length = std::hypot(other[0] - origin[0], other[1] - origin[1]);
+            double e_x = (other[0] - origin[0]) / length,
+                   e_y = (other[1] - origin[1]) / length;
+
+            // hull has positive orientation, so the normal (-e_y, e_x) points inwards
+            auto along = [&](size_t j) {
+                return (hull[j % n][0] - origin[0]) * e_x + (hull[j % n][1] - origin[1]) * e_y;
+            };
+
+            auto across = [&](size_t j) {
+                return -(hull[j % n][0] - origin[0]) * e_y + (hull[j % n][1] - origin[1]) * e_x;
+            };
+
+            while (along(right + 1) > along(right))
+                right = (right + 1) % n;
+
+            if (i == 0)
+                top = right;
+
+            while (across(top + 1) > across(top))
+                top = (top + 1) % n;
+
+            if (i == 0)
+                left = top;
+
+            while (along(left + 1) < along(left))
+                left = (left + 1) % n;
+
+            double min_along = along(left),
+                   max_along = along(right),
+                   height = across(top);
+
+            double area = (max_along - min_along) * height;
+            if (area < min_area)
+            {
+                min_area = area;
+
+                double center_along = (min_along + max_along) / 2,
+                       center_across = height / 2;
+
+                out.center = Vector2f{
+                    float(origin[0] + center_along * e_x - center_across * e_y),
+                    float(origin[1] + center_along * e_y + center_across * e_x)
+                };
+                out.size = Vector2f{float(max_along - min_along), float(height)};
+                out.angle = std::atan2(e_y, e_x);
+            }
+        }
+
+        return out;
+    }
+}
@@ -0,0 +1,189 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+namespace crisp
+{
+    template<FourierTransformMode Mode>
+    template<typename Inner_t>
+    void RealFourierTransform<Mode>::transform_from(const Image<Inner_t, 1>& image_in)
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        size_t m = image_in.get_size().x() * 2;
+        size_t n = image_in.get_size().y() * 2;
+        size_t half_n = n / 2 + 1;
+
+        _size = {m, n};
+
+        auto* in = FFTW::alloc_real(m*n);
+        auto* out = FFTW::alloc_complex(m*half_n);
+        auto plan = FourierPlanCache::get().template get_dft_r2c_2d<Value_t>(m, n);
+
+        // multiplying with (-1)^(x+y) centers the spectrum, m and n are always even
+        for (size_t x = 0, i = 0; x < m; ++x)
+            for (size_t y = 0; y < n; ++y, ++i)
+                in[i] = static_cast<Value_t>(image_in(x, y)) * ((x + y) % 2 == 0 ? 1 : -1);
+
+        FFTW::execute_r2c(plan.get(), in, out);
+
+        _min_spectrum = std::numeric_limits<Value_t>::max();
+        _max_spectrum = std::numeric_limits<Value_t>::min();
+
+        _spectrum.clear();
+        _spectrum.reserve(m*half_n);
+        _phase_angle.clear();
+        _phase_angle.reserve(m*half_n);
+
+        for (size_t i = 0; i < m*half_n; ++i)
+        {
+            auto f = std::complex<Value_t>(out[i][0], out[i][1]);
+            auto magnitude = abs(f);
+
+            _spectrum.emplace_back(magnitude);
+            _phase_angle.emplace_back(arg(f));
+
+            auto scaled = log(1 + magnitude);
+            _min_spectrum = std::min<Value_t>(_min_spectrum, scaled);
+            _max_spectrum = std::max<Value_t>(_max_spectrum, scaled);
+        }
+
+        FFTW::free(in);
+        FFTW::free(out);
+    }
+
+    template<FourierTransformMode Mode>
+    template<typename Image_t>
+    Image_t RealFourierTransform<Mode>::transform_to() const
+    {
+        using FFTW = detail::FFTW<Value_t>;
+
+        Image_t image_out;
+        image_out.create(get_size().x() / 2, get_size().y() / 2);
+
+        size_t m = get_size().x();
+        size_t n = get_size().y();
+        size_t half_n = n / 2 + 1;
+
+        auto* in = FFTW::alloc_complex(m*half_n);
+        auto* out = FFTW::alloc_real(m*n);
+        auto plan = FourierPlanCache::get().template get_dft_c2r_2d<Value_t>(m, n);
+
+        for (size_t i = 0; i < m*half_n; ++i)
+        {
+            auto f = std::polar<Value_t>(_spectrum.at(i), _phase_angle.at(i));
+            in[i][0] = f.real();
+            in[i][1] = f.imag();
+        }
+
+        FFTW::execute_c2r(plan.get(), in, out);
+
+        for (size_t x = 0; x < m/2; ++x)
+            for (size_t y = 0; y < n/2; ++y)
+                image_out(x, y) = static_cast<typename Image_t::Value_t>(out[x*n + y] / Value_t(m * n) * ((x + y) % 2 == 0 ? 1 : -1));
+
+        FFTW::free(in);
+        FFTW::free(out);
+
+        return image_out;
+    }
+
+    template<FourierTransformMode Mode>
+    GrayScaleImage RealFourierTransform<Mode>::as_image() const
+    {
+        GrayScaleImage out;
+        out.create(get_size().x(), get_size().y());
+
+        for (size_t x = 0; x < get_size().x(); ++x)
+        {
+            for (size_t y = 0; y < get_size().y(); ++y)
+            {
+                Value_t value = log(1 + get_component(x, y));
+
+                if (_min_spectrum < 0)
+                {
+                    value += _min_spectrum;
+                    value /= _max_spectrum;
+                }
+                else
+                {
+                    value -= _min_spectrum;
+                    value /= (_max_spectrum + _min_spectrum);
+                }
+
+                out(x, y) = value;
+            }
+        }
+        return out;
+    }
+
+    template<FourierTransformMode Mode>
+    std::pair<size_t, bool> RealFourierTransform<Mode>::to_index(size_t x, size_t y) const
+    {
+        size_t m = get_size().x(),
+               n = get_size().y();
+
+        if (y <= n / 2)
+            return {x * (n / 2 + 1) + y, false};
+        else
+            return {((m - x) % m) * (n / 2 + 1) + (n - y), true};
+    }
+
+    template<FourierTransformMode Mode>
+    std::complex<typename RealFourierTransform<Mode>::Value_t> RealFourierTransform<Mode>::get_coefficient(size_t x, size_t y) const
+    {
+        auto [i, is_conjugate] = to_index(x, y);
+        auto f = std::polar(_spectrum.at(i), _phase_angle.at(i));
+        return is_conjugate ? std::conj(f) : f;
+    }
+
+    template<FourierTransformMode Mode>
+    typename RealFourierTransform<Mode>::Value_t RealFourierTransform<Mode>::get_component(size_t x, size_t y) const
+    {
+        return _spectrum.at(to_index(x, y).first);
+    }
+
+    template<FourierTransformMode Mode>
+    typename RealFourierTransform<Mode>::Value_t& RealFourierTransform<Mode>::get_component(size_t x, size_t y)
+    {
+        return _spectrum.at(to_index(x, y).first);
+    }
+
+    template<FourierTransformMode Mode>
+    typename RealFourierTransform<Mode>::Value_t RealFourierTransform<Mode>::get_phase_angle(size_t x, size_t y) const
+    {
+        auto [i, is_conjugate] = to_index(x, y);
+        return is_conjugate ? -_phase_angle.at(i) : _phase_angle.at(i);
+    }
+
+    template<FourierTransformMode Mode>
+    typename RealFourierTransform<Mode>::Value_t RealFourierTransform<Mode>::get_dc_component() const
+    {
+        return get_component(get_size().x() / 2, get_size().y() / 2);
+    }
+
+    template<FourierTransformMode Mode>
+    Vector2ui RealFourierTransform<Mode>::get_size() const
+    {
+        return _size;
+    }
+
+    template<FourierTransformMode Mode>
+    Vector2ui RealFourierTransform<Mode>::get_stored_size() const
+    {
+        return Vector2ui{_size.x(), _size.y() / 2 + 1};
+    }
+
+    template<FourierTransformMode Mode>
+    std::vector<typename RealFourierTransform<Mode>::Value_t>& RealFourierTransform<Mode>::get_spectrum()
+    {
+        return _spectrum;
+    }
+
+    template<FourierTransformMode Mode>
+    std::vector<typename RealFourierTransform<Mode>::Value_t>& RealFourierTransform<Mode>::get_phase_angle()
+    {
+        return _phase_angle;
+    }
+}
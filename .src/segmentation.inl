@@ -6,985 +6,2450 @@
 #include <vector.hpp>
 #include <histogram.hpp>
 #include <whole_image_transform.hpp>
+#include <thread_pool.hpp>
 
 #include <map>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <deque>
 #include <list>
+#include <atomic>
+#include <unordered_map>
+#include <functional>
+#include <random>
+#include <bit>
+#include <numeric>
 
 namespace crisp::Segmentation
 {
+    namespace detail
+    {
+        // union-find over provisional labels, a root is always the smallest label of its set so parent[i] <= i holds
+        inline uint32_t find_root(std::vector<uint32_t>& parent, uint32_t i)
+        {
+            uint32_t root = i;
+            while (parent[root] != root)
+                root = parent[root];
+
+            while (parent[i] != root)
+            {
+                uint32_t next = parent[i];
+                parent[i] = root;
+                i = next;
+            }
+
+            return root;
+        }
+
+        inline uint32_t merge(std::vector<uint32_t>& parent, uint32_t a, uint32_t b)
+        {
+            a = find_root(parent, a);
+            b = find_root(parent, b);
+
+            if (a < b)
+                std::swap(a, b);
+
+            parent[a] = b;
+            return b;
+        }
+
+        // replace each provisional label by its final, consecutive label. Because parent[i] <= i, one ascending pass suffices
+        // and final labels are ordered by the first pixel of their component
+        template<typename Parent_t>
+        uint32_t flatten(Parent_t& parent)
+        {
+            uint32_t next = 1;
+            for (uint32_t i = 1; i < parent.size(); ++i)
+            {
+                if (parent[i] == i)
+                    parent[i] = next++;
+                else
+                    parent[i] = uint32_t(parent[parent[i]]);
+            }
+
+            return next;
+        }
+
+        // lock-free variants used to merge labels across stripes. Roots only ever get linked to smaller roots,
+        // so the resulting partition and each sets root are independent of the order in which threads merge
+        inline uint32_t find_root(std::vector<std::atomic<uint32_t>>& parent, uint32_t i)
+        {
+            uint32_t next;
+            while ((next = parent[i].load(std::memory_order_relaxed)) != i)
+                i = next;
+
+            return i;
+        }
+
+        inline void merge(std::vector<std::atomic<uint32_t>>& parent, uint32_t a, uint32_t b)
+        {
+            while (true)
+            {
+                a = find_root(parent, a);
+                b = find_root(parent, b);
+
+                if (a == b)
+                    return;
+
+                if (a < b)
+                    std::swap(a, b);
+
+                // fails if another thread linked a in the meantime, in which case we retry from the new root
+                uint32_t expected = a;
+                if (parent[a].compare_exchange_weak(expected, b, std::memory_order_relaxed))
+                    return;
+            }
+        }
+
+        // horizontal band of rows labeled independently of all others
+        struct LabelingStripe
+        {
+            size_t y_begin, y_end;
+
+            // maps provisional labels to labels local to the stripe
+            std::vector<uint32_t> local;
+            uint32_t n_labels;
+
+            // offset of local labels in the global label space
+            uint32_t offset;
+        };
+
+        // stripes should be large enough for the merge to be negligible
+        constexpr size_t min_labeling_stripe_size = 1 << 14;
+    }
+
+    inline size_t ConnectedComponents::get_n_components() const
+    {
+        return statistics.empty() ? 0 : statistics.size() - 1;
+    }
+
+    inline ImageSegment ConnectedComponents::get_segment(uint32_t label) const
+    {
+        ImageSegment out;
+
+        const auto& stats = statistics.at(label);
+        if (stats.n_pixels == 0)
+            return out;
+
+        // visiting pixels in the sets order allows constant time insertion at the end
+        for (size_t y = stats.min.y(); y <= stats.max.y(); ++y)
+            for (size_t x = stats.min.x(); x <= stats.max.x(); ++x)
+                if (labels._data(x, y).x() == label)
+                    out.emplace_hint(out.end(), Vector2ui{x, y});
+
+        return out;
+    }
+
+    inline RunLengthSegment ConnectedComponents::get_run_length_segment(uint32_t label) const
+    {
+        RunLengthSegment out;
+
+        const auto& stats = statistics.at(label);
+        if (stats.n_pixels == 0)
+            return out;
+
+        for (size_t y = stats.min.y(); y <= stats.max.y(); ++y)
+        {
+            size_t x = stats.min.x();
+            while (x <= stats.max.x())
+            {
+                if (labels._data(x, y).x() != label)
+                {
+                    ++x;
+                    continue;
+                }
+
+                size_t x_begin = x;
+                while (x <= stats.max.x() and labels._data(x, y).x() == label)
+                    ++x;
+
+                out.insert_run(y, x_begin, x);
+            }
+        }
+
+        return out;
+    }
+
+    template<typename Image_t>
+    ConnectedComponents label_connected_components(const Image_t& image, Connectivity connectivity, std::optional<typename Image_t::Value_t> background)
+    {
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y();
+
+        ConnectedComponents out;
+        out.labels.create(width, height, 0);
+
+        if (width == 0 or height == 0)
+        {
+            out.statistics.resize(1);
+            return out;
+        }
+
+        const auto& data = image._data;
+        auto& labels = out.labels._data;
+
+        auto& pool = ThreadPool::get();
+
+        size_t min_stripe_height = std::max<size_t>(detail::min_labeling_stripe_size / width, 1);
+        size_t n_stripes = std::clamp<size_t>(height / min_stripe_height, 1, pool.get_n_threads() * 4);
+        size_t stripe_height = (height + n_stripes - 1) / n_stripes;
+        n_stripes = (height + stripe_height - 1) / stripe_height;
+
+        std::vector<detail::LabelingStripe> stripes(n_stripes);
+        for (size_t i = 0; i < n_stripes; ++i)
+        {
+            stripes[i].y_begin = i * stripe_height;
+            stripes[i].y_end = std::min(height, (i + 1) * stripe_height);
+        }
+
+        // first pass, per stripe: assign provisional labels and record equivalences. Only already visited neighbors inside the
+        // stripe are inspected, and neighbors connected among themselves are skipped so each pixel performs at most one merge
+        pool.parallel_for(n_stripes, [&](size_t stripe_i)
+        {
+            auto& stripe = stripes[stripe_i];
+            auto& parent = stripe.local;
+            parent = {0};
+
+            for (size_t y = stripe.y_begin; y < stripe.y_end; ++y)
+            {
+                const bool has_top = y > stripe.y_begin;
+
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const auto& value = data(x, y);
+
+                    if (background.has_value() and value == background.value())
+                    {
+                        labels(x, y).x() = 0;
+                        continue;
+                    }
+
+                    auto connected = [&](size_t nx, size_t ny) -> uint32_t
+                    {
+                        return data(nx, ny) == value ? labels(nx, ny).x() : 0;
+                    };
+
+                    const uint32_t left = x > 0 ? connected(x - 1, y) : 0,
+                                   top = has_top ? connected(x, y - 1) : 0;
+
+                    uint32_t label = 0;
+
+                    if (connectivity == Connectivity::FOUR)
+                    {
+                        if (top != 0 and left != 0)
+                            label = top == left ? top : detail::merge(parent, top, left);
+                        else
+                            label = top != 0 ? top : left;
+                    }
+                    else if (top != 0)
+                        label = top;    // top touches all other visited neighbors
+                    else
+                    {
+                        const uint32_t top_right = has_top and x + 1 < width ? connected(x + 1, y - 1) : 0;
+
+                        // left and top left touch each other, only one needs to be considered
+                        uint32_t left_or_top_left = left;
+                        if (left_or_top_left == 0 and x > 0 and has_top)
+                            left_or_top_left = connected(x - 1, y - 1);
+
+                        if (top_right != 0 and left_or_top_left != 0)
+                            label = top_right == left_or_top_left ? top_right : detail::merge(parent, top_right, left_or_top_left);
+                        else
+                            label = top_right != 0 ? top_right : left_or_top_left;
+                    }
+
+                    if (label == 0)
+                    {
+                        label = parent.size();
+                        parent.push_back(label);
+                    }
+
+                    labels(x, y).x() = label;
+                }
+            }
+
+            stripe.n_labels = detail::flatten(parent) - 1;
+        });
+
+        // stripes occupy consecutive ranges of the global label space in top-to-bottom order,
+        // so global labels are ordered by the first pixel of each stripe-local component
+        uint32_t n_global = 1;
+        for (auto& stripe : stripes)
+        {
+            stripe.offset = n_global - 1;
+            n_global += stripe.n_labels;
+        }
+
+        auto to_global = [&](const detail::LabelingStripe& stripe, uint32_t provisional) -> uint32_t
+        {
+            return provisional == 0 ? 0 : stripe.offset + stripe.local[provisional];
+        };
+
+        std::vector<std::atomic<uint32_t>> global(n_global);
+        pool.parallel_for_ranges(n_global, [&](size_t begin, size_t end){
+            for (size_t i = begin; i < end; ++i)
+                global[i].store(i, std::memory_order_relaxed);
+        }, detail::min_labeling_stripe_size);
+
+        // merge components touching across stripe borders
+        pool.parallel_for(n_stripes - 1, [&](size_t i)
+        {
+            const auto& above = stripes[i];
+            const auto& below = stripes[i + 1];
+            const size_t y = below.y_begin;
+
+            for (size_t x = 0; x < width; ++x)
+            {
+                const uint32_t label = to_global(below, labels(x, y).x());
+                if (label == 0)
+                    continue;
+
+                const auto& value = data(x, y);
+                auto merge_if_connected = [&](size_t nx)
+                {
+                    const uint32_t other = to_global(above, labels(nx, y - 1).x());
+                    if (other != 0 and data(nx, y - 1) == value)
+                        detail::merge(global, label, other);
+                };
+
+                merge_if_connected(x);
+
+                if (connectivity == Connectivity::EIGHT)
+                {
+                    if (x > 0)
+                        merge_if_connected(x - 1);
+
+                    if (x + 1 < width)
+                        merge_if_connected(x + 1);
+                }
+            }
+        });
+
+        // each sets root is its smallest label, which belongs to the component whose first pixel comes first, so flattening
+        // produces the same labels as labeling the image in one piece, regardless of the number of stripes or threads
+        const uint32_t n_labels = detail::flatten(global);
+
+        // second pass: resolve final labels and accumulate statistics per stripe, then combine them
+        std::vector<std::vector<ComponentStatistics>> stripe_statistics(n_stripes);
+        std::vector<std::vector<Vector<double, 2>>> stripe_sums(n_stripes);
+
+        pool.parallel_for(n_stripes, [&](size_t stripe_i)
+        {
+            auto& stripe = stripes[stripe_i];
+            auto& statistics = stripe_statistics[stripe_i];
+            auto& sums = stripe_sums[stripe_i];
+
+            statistics.resize(stripe.n_labels + 1);
+            for (auto& stats : statistics)
+                stats.min = Vector2ui{width, height};
+
+            sums.resize(stripe.n_labels + 1, Vector<double, 2>{0, 0});
+
+            for (size_t y = stripe.y_begin; y < stripe.y_end; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const uint32_t local = stripe.local[labels(x, y).x()];
+                    labels(x, y).x() = local == 0 ? 0 : uint32_t(global[stripe.offset + local]);
+
+                    auto& stats = statistics[local];
+                    stats.n_pixels += 1;
+                    stats.min.x() = std::min(stats.min.x(), x);
+                    stats.min.y() = std::min(stats.min.y(), y);
+                    stats.max.x() = std::max(stats.max.x(), x);
+                    stats.max.y() = std::max(stats.max.y(), y);
+                    sums[local].x() += x;
+                    sums[local].y() += y;
+                }
+            }
+        });
+
+        out.statistics.resize(n_labels);
+        for (auto& stats : out.statistics)
+            stats.min = Vector2ui{width, height};
+
+        std::vector<Vector<double, 2>> coordinate_sums(n_labels, Vector<double, 2>{0, 0});
+
+        for (size_t stripe_i = 0; stripe_i < n_stripes; ++stripe_i)
+        {
+            for (uint32_t local = 0; local < stripe_statistics[stripe_i].size(); ++local)
+            {
+                const auto& from = stripe_statistics[stripe_i][local];
+                if (from.n_pixels == 0)
+                    continue;
+
+                const uint32_t label = local == 0 ? 0 : uint32_t(global[stripes[stripe_i].offset + local]);
+                auto& to = out.statistics[label];
+
+                to.n_pixels += from.n_pixels;
+                to.min.x() = std::min(to.min.x(), from.min.x());
+                to.min.y() = std::min(to.min.y(), from.min.y());
+                to.max.x() = std::max(to.max.x(), from.max.x());
+                to.max.y() = std::max(to.max.y(), from.max.y());
+                coordinate_sums[label] += stripe_sums[stripe_i][local];
+            }
+        }
+
+        for (size_t i = 0; i < n_labels; ++i)
+        {
+            auto& stats = out.statistics[i];
+            if (stats.n_pixels == 0)
+            {
+                stats.min = Vector2ui{0, 0};
+                continue;
+            }
+
+            stats.centroid = Vector2f{float(coordinate_sums[i].x() / stats.n_pixels), float(coordinate_sums[i].y() / stats.n_pixels)};
+        }
+
+        return out;
+    }
+
+    namespace detail
+    {
+        // hashes and compares pixel values component-wise, so distinct values never share a class
+        template<typename Value_t>
+        struct PixelValueHash
+        {
+            size_t operator()(const Value_t& value) const
+            {
+                using Inner_t = typename Value_t::Value_t;
+
+                size_t seed = 0;
+                for (size_t i = 0; i < Value_t::size(); ++i)
+                    seed ^= std::hash<Inner_t>{}(value.at(i)) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+                return seed;
+            }
+        };
+
+        template<typename Value_t>
+        struct PixelValueEqual
+        {
+            bool operator()(const Value_t& a, const Value_t& b) const
+            {
+                for (size_t i = 0; i < Value_t::size(); ++i)
+                    if (a.at(i) != b.at(i))
+                        return false;
+
+                return true;
+            }
+        };
+    }
+
+    inline size_t ValuePartition::get_n_classes() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    inline size_t ValuePartition::get_n_pixels(size_t class_i) const
+    {
+        return offsets.at(class_i + 1) - offsets.at(class_i);
+    }
+
+    inline ImageSegment ValuePartition::get_segment(size_t class_i) const
+    {
+        ImageSegment out;
+
+        const size_t width = labels.get_size().x();
+        for (size_t i = offsets.at(class_i); i < offsets.at(class_i + 1); ++i)
+            out.emplace_hint(out.end(), Vector2ui{pixel_indices[i] % width, pixel_indices[i] / width});
+
+        return out;
+    }
+
+    inline RunLengthSegment ValuePartition::get_run_length_segment(size_t class_i) const
+    {
+        RunLengthSegment out;
+
+        const size_t width = labels.get_size().x();
+        for (size_t i = offsets.at(class_i); i < offsets.at(class_i + 1); ++i)
+        {
+            // consecutive indices in the same row form one run
+            size_t begin = pixel_indices[i];
+            while (i + 1 < offsets[class_i + 1] and pixel_indices[i + 1] == pixel_indices[i] + 1 and pixel_indices[i + 1] % width != 0)
+                ++i;
+
+            out.insert_run(begin / width, begin % width, pixel_indices[i] % width + 1);
+        }
+
+        return out;
+    }
+
+    template<typename Image_t>
+    ValuePartition partition_by_value(const Image_t& image)
+    {
+        using Value_t = typename Image_t::Value_t;
+        using Inner_t = typename Value_t::Value_t;
+
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y();
+
+        ValuePartition out;
+        out.labels.create(width, height, 0);
+
+        const auto& data = image._data;
+        auto& labels = out.labels._data;
+
+        // first pass: assign a class to each pixel and count the pixels per class
+        std::vector<size_t> counts;
+
+        if constexpr (std::is_integral_v<Inner_t> and sizeof(Inner_t) * Value_t::size() <= 2)
+        {
+            // quantized values, the concatenated bits of all components index a lookup table directly
+            constexpr size_t n_bits = std::is_same_v<Inner_t, bool> ? 1 : sizeof(Inner_t) * 8;
+
+            auto to_bits = [](Inner_t value) -> size_t
+            {
+                if constexpr (std::is_same_v<Inner_t, bool>)
+                    return value;
+                else
+                    return std::make_unsigned_t<Inner_t>(value);
+            };
+
+            std::vector<uint32_t> key_to_class(size_t(1) << (n_bits * Value_t::size()), std::numeric_limits<uint32_t>::max());
+
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    size_t key = 0;
+                    for (size_t i = 0; i < Value_t::size(); ++i)
+                        key |= to_bits(data(x, y).at(i)) << (n_bits * i);
+
+                    uint32_t& class_i = key_to_class[key];
+                    if (class_i == std::numeric_limits<uint32_t>::max())
+                    {
+                        class_i = counts.size();
+                        counts.push_back(0);
+                    }
+
+                    labels(x, y).x() = class_i;
+                    counts[class_i] += 1;
+                }
+            }
+        }
+        else
+        {
+            std::unordered_map<Value_t, uint32_t, detail::PixelValueHash<Value_t>, detail::PixelValueEqual<Value_t>> value_to_class;
+
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const auto& value = data(x, y);
+
+                    // neighboring pixels often share a value, reuse the left neighbors class to skip the lookup
+                    uint32_t class_i;
+                    if (x > 0 and detail::PixelValueEqual<Value_t>{}(value, data(x - 1, y)))
+                        class_i = labels(x - 1, y).x();
+                    else
+                    {
+                        auto it = value_to_class.try_emplace(value, counts.size()).first;
+                        class_i = it->second;
+
+                        if (class_i == counts.size())
+                            counts.push_back(0);
+                    }
+
+                    labels(x, y).x() = class_i;
+                    counts[class_i] += 1;
+                }
+            }
+        }
+
+        // second pass: counting sort of the pixel indices by class, visiting pixels in order keeps each class sorted
+        out.offsets.resize(counts.size() + 1, 0);
+        for (size_t i = 0; i < counts.size(); ++i)
+            out.offsets[i + 1] = out.offsets[i] + counts[i];
+
+        std::vector<size_t> next(out.offsets.begin(), out.offsets.end() - 1);
+        out.pixel_indices.resize(width * height);
+
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                out.pixel_indices[next[labels(x, y).x()]++] = x + y * width;
+
+        return out;
+    }
+
     template<typename Image_t>
     std::vector<ImageSegment> decompose_into_segments(const Image_t& image, size_t min_segment_size)
     {
-        using Value_t = typename Image_t::Value_t;
+        auto partition = partition_by_value(image);
+
+        std::vector<ImageSegment> out;
+        for (size_t i = 0; i < partition.get_n_classes(); ++i)
+            if (partition.get_n_pixels(i) > min_segment_size)
+                out.push_back(partition.get_segment(i));
+
+        return out;
+    }
+
+    template<typename Image_t>
+    std::vector<ImageSegment> decompose_into_connected_segments(const Image_t& image, size_t min_segment_size, Connectivity connectivity)
+    {
+        auto components = label_connected_components(image, connectivity);
+        const auto& statistics = components.statistics;
+
+        std::vector<ImageSegment> segments;
+        std::vector<ImageSegment*> label_to_segment(statistics.size(), nullptr);
+
+        for (uint32_t label = 1; label < statistics.size(); ++label)
+            if (statistics[label].n_pixels >= min_segment_size)
+                segments.emplace_back();
+
+        for (uint32_t label = 1, i = 0; label < statistics.size(); ++label)
+            if (statistics[label].n_pixels >= min_segment_size)
+                label_to_segment[label] = &segments[i++];
+
+        // pixels are visited in the sets order so each insertion is constant time
+        for (size_t y = 0; y < image.get_size().y(); ++y)
+        {
+            for (size_t x = 0; x < image.get_size().x(); ++x)
+            {
+                auto* segment = label_to_segment[components.labels._data(x, y).x()];
+                if (segment != nullptr)
+                    segment->emplace_hint(segment->end(), Vector2ui{x, y});
+            }
+        }
+
+        return segments;
+    }
+
+    template<typename Inner_t>
+    BinaryImage manual_threshold(const Image<Inner_t, 1>& image, Inner_t threshold)
+    {
+        BinaryImage out;
+        out.create(image.get_size().x(), image.get_size().y());
+
+        for (size_t x = 0; x < image.get_size().x(); ++x)
+            for (size_t y = 0; y < image.get_size().y(); ++y)
+                out(x, y) = image(x, y) > threshold;
+
+        return out;
+    }
+    
+    namespace detail
+    {
+        // classify each pixel by comparing its histogram bin against the thresholds
+        template<size_t N_Bins, typename Inner_t, typename Function_t>
+        void apply_bin_thresholds(const Image<Inner_t, 1>& image, Function_t&& assign)
+        {
+            ThreadPool::get().parallel_for_ranges(image.get_size().y(), [&](size_t y_begin, size_t y_end)
+            {
+                for (size_t y = y_begin; y < y_end; ++y)
+                    for (size_t x = 0; x < image.get_size().x(); ++x)
+                        assign(x, y, Histogram<N_Bins>::to_bin_index(float(image._data(x, y))));
+            }, 16);
+        }
+    }
+
+    template<typename Inner_t>
+    BinaryImage basic_threshold(const Image<Inner_t, 1>& image)
+    {
+        auto histogram = Histogram<256>();
+        histogram.create_from(image);
+
+        // cumulative count and intensity sum, so the means left and right of any threshold are available in O(1)
+        const auto& counts = histogram.get_counts();
+        std::vector<double> cumulative_n(counts.size() + 1, 0),
+                            cumulative_sum(counts.size() + 1, 0);
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            cumulative_n[i + 1] = cumulative_n[i] + counts[i];
+            cumulative_sum[i + 1] = cumulative_sum[i] + counts[i] * double(i);
+        }
+
+        const double total_n = cumulative_n.back(),
+                     total_sum = cumulative_sum.back();
+
+        // pixels in bins [0, threshold) are left, all others are right
+        size_t threshold = std::clamp<size_t>(histogram.mean() * 256, 1, counts.size() - 1);
+
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            double left_n = cumulative_n[threshold],
+                   right_n = total_n - left_n;
+
+            if (left_n == 0 or right_n == 0)
+                break;
+
+            double left_mean = cumulative_sum[threshold] / left_n,
+                   right_mean = (total_sum - cumulative_sum[threshold]) / right_n;
+
+            size_t new_threshold = std::clamp<size_t>(std::round(0.5 * (left_mean + right_mean)), 1, counts.size() - 1);
+            if (new_threshold == threshold)
+                break;
+
+            threshold = new_threshold;
+        }
+
+        auto out = BinaryImage();
+        out.create(image.get_size().x(), image.get_size().y());
+
+        detail::apply_bin_thresholds<256>(image, [&](size_t x, size_t y, size_t bin){
+            out._data(x, y) = bin >= threshold;
+        });
+
+        return out;
+    }
+
+    template<size_t N_Bins>
+    size_t compute_otsu_threshold(const Histogram<N_Bins>& histogram)
+    {
+        const auto& counts = histogram.get_counts();
+
+        double total_n = 0, total_sum = 0;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            total_n += counts[i];
+            total_sum += counts[i] * double(i);
+        }
+
+        if (total_n == 0)
+            return 0;
+
+        const double global_mean = total_sum / total_n;
+
+        // between-class variance for threshold k from the cumulative probability and first moment up to k
+        double cumulative_p = 0,
+               cumulative_mean = 0;
+
+        size_t max_k = 0;
+        double max_sigma = 0;
+
+        for (size_t k = 0; k + 1 < counts.size(); ++k)
+        {
+            double p_k = counts[k] / total_n;
+            cumulative_p += p_k;
+            cumulative_mean += p_k * k;
+
+            if (cumulative_p <= 0 or cumulative_p >= 1)
+                continue;
+
+            double sigma = std::pow(global_mean * cumulative_p - cumulative_mean, 2) / (cumulative_p * (1 - cumulative_p));
+            if (sigma > max_sigma)
+            {
+                max_sigma = sigma;
+                max_k = k;
+            }
+        }
+
+        return max_k;
+    }
+
+    template<size_t N_Bins>
+    std::vector<size_t> compute_multi_otsu_thresholds(const Histogram<N_Bins>& histogram, size_t n_thresholds)
+    {
+        const auto& counts = histogram.get_counts();
+        const size_t n_bins = counts.size();
+        const size_t n_classes = std::min(n_thresholds + 1, n_bins);
+
+        if (n_thresholds == 0)
+            return {};
+
+        // maximizing the between-class variance is equivalent to maximizing the sum of (class sum)^2 / (class size),
+        // which only depends on cumulative counts and sums. Class [a, b) covers bins a to b-1
+        std::vector<double> cumulative_n(n_bins + 1, 0),
+                            cumulative_sum(n_bins + 1, 0);
+
+        for (size_t i = 0; i < n_bins; ++i)
+        {
+            cumulative_n[i + 1] = cumulative_n[i] + counts[i];
+            cumulative_sum[i + 1] = cumulative_sum[i] + counts[i] * double(i);
+        }
+
+        auto class_score = [&](size_t a, size_t b) -> double
+        {
+            double n = cumulative_n[b] - cumulative_n[a];
+            if (n <= 0)
+                return 0;
+
+            double sum = cumulative_sum[b] - cumulative_sum[a];
+            return sum * sum / n;
+        };
+
+        // score[b] is the best score of splitting bins [0, b) into c classes, split[c][b] the start of the last class.
+        // The within-class variance satisfies the quadrangle inequality, so the optimal split is monotone in b
+        // and each layer can be computed by divide and conquer
+        std::vector<double> previous(n_bins + 1, -1), current(n_bins + 1, -1);
+        std::vector<std::vector<size_t>> split(n_classes, std::vector<size_t>(n_bins + 1, 0));
+
+        for (size_t b = 1; b <= n_bins; ++b)
+            previous[b] = class_score(0, b);
+
+        for (size_t c = 1; c < n_classes; ++c)
+        {
+            std::fill(current.begin(), current.end(), -1);
+
+            std::function<void(size_t, size_t, size_t, size_t)> solve = [&](size_t b_begin, size_t b_end, size_t a_min, size_t a_max)
+            {
+                if (b_begin >= b_end)
+                    return;
+
+                const size_t b = b_begin + (b_end - b_begin) / 2;
+
+                double best = -1;
+                size_t best_a = a_min;
+                for (size_t a = a_min; a <= std::min(a_max, b - 1); ++a)
+                {
+                    double score = previous[a] + class_score(a, b);
+                    if (score > best)
+                    {
+                        best = score;
+                        best_a = a;
+                    }
+                }
+
+                current[b] = best;
+                split[c][b] = best_a;
+
+                solve(b_begin, b, a_min, best_a);
+                solve(b + 1, b_end, best_a, a_max);
+            };
+
+            // the first c classes need at least c bins
+            solve(c + 1, n_bins + 1, c, n_bins - 1);
+            std::swap(previous, current);
+        }
+
+        std::vector<size_t> out(n_classes - 1);
+        size_t end = n_bins;
+        for (size_t c = n_classes - 1; c > 0; --c)
+        {
+            end = split[c][end];
+            out[c - 1] = end - 1;
+        }
+
+        return out;
+    }
+
+    template<typename Inner_t>
+    BinaryImage otsu_threshold(const Image<Inner_t, 1>& image)
+    {
+        auto histogram = Histogram<256>();
+        histogram.create_from(image);
+
+        const size_t threshold = compute_otsu_threshold(histogram);
+
+        auto out = BinaryImage();
+        out.create(image.get_size().x(), image.get_size().y());
+
+        detail::apply_bin_thresholds<256>(image, [&](size_t x, size_t y, size_t bin){
+            out._data(x, y) = bin > threshold;
+        });
+
+        return out;
+    }
+
+    template<typename Inner_t>
+    LabelImage multi_otsu_threshold(const Image<Inner_t, 1>& image, size_t n_thresholds)
+    {
+        auto histogram = Histogram<256>();
+        histogram.create_from(image);
+
+        const auto thresholds = compute_multi_otsu_thresholds(histogram, n_thresholds);
+
+        // lookup table from bin to class
+        std::vector<uint32_t> bin_to_class(histogram.get_counts().size());
+        for (size_t bin = 0, class_i = 0; bin < bin_to_class.size(); ++bin)
+        {
+            while (class_i < thresholds.size() and bin > thresholds[class_i])
+                ++class_i;
+
+            bin_to_class[bin] = class_i;
+        }
+
+        LabelImage out;
+        out.create(image.get_size().x(), image.get_size().y(), 0);
+
+        detail::apply_bin_thresholds<256>(image, [&](size_t x, size_t y, size_t bin){
+            out._data(x, y).x() = bin_to_class[bin];
+        });
+
+        return out;
+    }
+
+    template<typename Inner_t>
+    BinaryImage variable_threshold(const Image<Inner_t, 1>& image, float tail_length_factor)
+    {
+        BinaryImage out;
+        out.create(image.get_size().x(), image.get_size().y());
+
+        std::list<float> tail;
+        float current_sum = 0;
+
+        size_t tail_length = (image.get_size().x() + image.get_size().y()) * tail_length_factor;
+        size_t k = 0;
+
+        auto update = [&](size_t x, size_t y, size_t i) 
+        {
+            out(x, y) = image(x, y) > (current_sum / tail.size());
+
+            if (i > tail_length)
+            {
+                current_sum -= tail.front();
+                tail.erase(tail.begin());
+            }
+
+            tail.emplace_back(image(x, y));
+            current_sum += tail.back();
+        };
+
+        int top = 0,
+            bottom = image.get_size().x() - 1,
+            left = 0,
+            right = image.get_size().y() - 1;
+
+        int direction = 1;
+
+        while (top <= bottom and left <= right)
+        {
+            if (direction == 1)
+            {
+                for (int i = left; i <= right; ++i, k++)
+                    update(top, i, k);
+
+                ++top;
+                direction = 2;
+            }
+
+            else if (direction == 2)
+            {
+                for (int i = top; i <= bottom; ++i, k++)
+                    update(i, right, k);
+
+                --right;
+                direction = 3;
+            }
+
+            else if (direction == 3)
+            {
+                for (int i = right; i >= left; --i, k++)
+                    update(bottom, i, k);
+
+                --bottom;
+                direction = 4;
+            }
+            else if (direction == 4)
+            {
+                for (int i = bottom; i >= top; --i)
+                    update(i, left, k);
+
+                ++left;
+                direction = 1;
+            }
+        }
+
+        return out;
+    }
+    
+    namespace detail
+    {
+        // summed-area tables of the values and squared values with one row and column of zeros in front,
+        // the sum over any rectangle can be read from 4 entries regardless of its size
+        struct IntegralImage
+        {
+            template<typename Inner_t>
+            IntegralImage(const Image<Inner_t, 1>& image)
+                : width(image.get_size().x()), height(image.get_size().y()),
+                  sum((width + 1) * (height + 1), 0), squared_sum((width + 1) * (height + 1), 0)
+            {
+                auto& pool = ThreadPool::get();
+                const size_t stride = width + 1;
+
+                // prefix sums along x, rows are independent
+                pool.parallel_for_ranges(height, [&](size_t y_begin, size_t y_end)
+                {
+                    for (size_t y = y_begin; y < y_end; ++y)
+                    {
+                        double row_sum = 0, row_squared_sum = 0;
+                        for (size_t x = 0; x < width; ++x)
+                        {
+                            double value = float(image._data(x, y));
+                            row_sum += value;
+                            row_squared_sum += value * value;
+
+                            sum[(x + 1) + (y + 1) * stride] = row_sum;
+                            squared_sum[(x + 1) + (y + 1) * stride] = row_squared_sum;
+                        }
+                    }
+                }, 16);
+
+                // prefix sums along y, each range of columns is independent and walked row by row to stay contiguous
+                pool.parallel_for_ranges(width, [&](size_t x_begin, size_t x_end)
+                {
+                    for (size_t y = 1; y < height; ++y)
+                    {
+                        for (size_t x = x_begin; x < x_end; ++x)
+                        {
+                            sum[(x + 1) + (y + 1) * stride] += sum[(x + 1) + y * stride];
+                            squared_sum[(x + 1) + (y + 1) * stride] += squared_sum[(x + 1) + y * stride];
+                        }
+                    }
+                }, 256);
+            }
+
+            // mean and variance of the window of given size centered on (x, y), clipped to the image
+            std::pair<double, double> get_mean_and_variance(size_t x, size_t y, size_t window_size) const
+            {
+                const size_t half = window_size / 2;
+                const size_t x_min = x >= half ? x - half : 0,
+                             y_min = y >= half ? y - half : 0,
+                             x_max = std::min(width, x + half + 1),
+                             y_max = std::min(height, y + half + 1);
+
+                const size_t stride = width + 1;
+                auto rectangle = [&](const std::vector<double>& table) -> double
+                {
+                    return table[x_max + y_max * stride] - table[x_min + y_max * stride] - table[x_max + y_min * stride] + table[x_min + y_min * stride];
+                };
+
+                const double n = (x_max - x_min) * (y_max - y_min);
+                const double mean = rectangle(sum) / n;
+                const double variance = std::max(rectangle(squared_sum) / n - mean * mean, 0.0);
+
+                return {mean, variance};
+            }
+
+            size_t width, height;
+            std::vector<double> sum, squared_sum;
+        };
+
+        // threshold each pixel against a function of its windows mean and variance
+        template<typename Inner_t, typename Function_t>
+        BinaryImage local_threshold(const Image<Inner_t, 1>& image, size_t window_size, Function_t&& is_foreground)
+        {
+            BinaryImage out;
+            out.create(image.get_size().x(), image.get_size().y());
+
+            const auto integral = IntegralImage(image);
+
+            ThreadPool::get().parallel_for_ranges(image.get_size().y(), [&](size_t y_begin, size_t y_end)
+            {
+                for (size_t y = y_begin; y < y_end; ++y)
+                {
+                    for (size_t x = 0; x < image.get_size().x(); ++x)
+                    {
+                        auto [mean, variance] = integral.get_mean_and_variance(x, y, window_size);
+                        out._data(x, y) = is_foreground(float(image._data(x, y)), mean, variance);
+                    }
+                }
+            }, 16);
+
+            return out;
+        }
+    }
+
+    template<typename Inner_t>
+    BinaryImage neighborhood_threshold(const Image<Inner_t, 1>& image, size_t neighborhood_size)
+    {
+        const size_t spread = 7;
+        return detail::local_threshold(image, 2 * spread * neighborhood_size + 1, [](float value, double mean, double) {
+            return value < mean;
+        });
+    }
+
+    template<typename Inner_t>
+    BinaryImage niblack_threshold(const Image<Inner_t, 1>& image, size_t window_size, float k)
+    {
+        return detail::local_threshold(image, window_size, [k](float value, double mean, double variance) {
+            return value > mean + k * std::sqrt(variance);
+        });
+    }
+
+    template<typename Inner_t>
+    BinaryImage sauvola_threshold(const Image<Inner_t, 1>& image, size_t window_size, float k, float r)
+    {
+        return detail::local_threshold(image, window_size, [k, r](float value, double mean, double variance) {
+            return value > mean * (1 + k * (std::sqrt(variance) / r - 1));
+        });
+    }
+
+    template<typename Inner_t>
+    BinaryImage bradley_threshold(const Image<Inner_t, 1>& image, size_t window_size, float t)
+    {
+        return detail::local_threshold(image, window_size, [t](float value, double mean, double) {
+            return value > mean * (1 - t);
+        });
+    }
+
+    template<typename T, size_t N>
+    Texture<T, N> threshold(const Texture<T, N>& texture, size_t neighborhood_size, size_t correction)
+    {
+        assert(neighborhood_size > 0);
+
+        auto out = texture;
+
+        auto shader = State::register_shader("local_threshold.glsl");
+        auto program = State::register_program(shader);
+        State::bind_shader_program(program);
+        State::free_shader(shader);
+
+        State::set_uint(program, "_neighborhood_size", neighborhood_size);
+        State::set_uint(program, "_correction", correction);
+
+        auto& workspace = out.get_workspace();
+        workspace.display();
+        workspace.yield();
+
+        return out;
+    }
+
+    namespace detail
+    {
+        // assign each pixel the mean value of all pixels with the same label
+        template<typename Image_t>
+        Image_t recolor_by_label(const Image_t& image, const LabelImage& labels, size_t n_labels)
+        {
+            using Value_t = typename Image_t::Value_t;
+            constexpr size_t n_planes = Value_t::size();
 
-        std::vector<ImageSegment> segments;
-        std::unordered_map<size_t, size_t> value_to_index;
+            std::vector<double> sums(n_labels * n_planes, 0);
+            std::vector<size_t> counts(n_labels, 0);
 
-        for (size_t y = 1; y < image.get_size().y(); ++y)
-            for (size_t x = 1; x < image.get_size().x(); ++x)
+            for (size_t y = 0; y < image.get_size().y(); ++y)
             {
-                auto value = image(x, y);
-                if (value_to_index.find(value.to_hash()) == value_to_index.end())
+                for (size_t x = 0; x < image.get_size().x(); ++x)
                 {
-                    segments.emplace_back();
-                    value_to_index.emplace(value.to_hash(), segments.size() - 1);
-                }
+                    const uint32_t label = labels._data(x, y).x();
+                    for (size_t i = 0; i < n_planes; ++i)
+                        sums[label * n_planes + i] += image._data(x, y).at(i);
 
-                segments.at(value_to_index.at(value.to_hash())).insert(Vector2ui{x, y});
+                    counts[label] += 1;
+                }
             }
 
-        std::vector<ImageSegment> out;
-        for (auto& s : segments)
-            if (s.size() > min_segment_size)
-                out.push_back(s);
+            std::vector<Value_t> means(n_labels);
+            for (size_t label = 0; label < n_labels; ++label)
+                for (size_t i = 0; i < n_planes; ++i)
+                    means[label].at(i) = counts[label] == 0 ? 0 : sums[label * n_planes + i] / counts[label];
 
-        return out;
+            Image_t out = image;
+            for (size_t y = 0; y < image.get_size().y(); ++y)
+                for (size_t x = 0; x < image.get_size().x(); ++x)
+                    out._data(x, y) = means[labels._data(x, y).x()];
+
+            return out;
+        }
     }
 
     template<typename Image_t>
-    std::vector<ImageSegment> decompose_into_connected_segments(const Image_t& image, size_t min_segment_size)
+    LabelImage compute_superpixels(const Image_t& image, size_t n_superpixels, float compactness, size_t max_n_iterations)
     {
         using Value_t = typename Image_t::Value_t;
+        constexpr size_t n_planes = Value_t::size();
 
-        std::vector<ImageSegment> segments;
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y(),
+                     n_pixels = width * height;
+
+        LabelImage out;
+        out.create(width, height, 0);
+
+        if (n_pixels == 0)
+            return out;
 
-        BinaryImage seen;
-        seen.create(image.get_size().x(), image.get_size().y());
-        Value_t color;
+        n_superpixels = std::clamp<size_t>(n_superpixels, 1, n_pixels);
+        const float spacing = std::sqrt(n_pixels / float(n_superpixels));
+        const float spatial_weight = (compactness / spacing) * (compactness / spacing);
+        const int window = std::ceil(spacing);
 
-        for (size_t y = 0; y < seen.get_size().y(); ++y)
+        // flat copy of all values, so the inner loop reads contiguous floats
+        std::vector<float> values(n_pixels * n_planes);
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                for (size_t i = 0; i < n_planes; ++i)
+                    values[(x + y * width) * n_planes + i] = image._data(x, y).at(i);
+
+        // cluster centers as contiguous arrays, placed on a regular grid and moved to the lowest gradient in their 3x3 neighborhood
+        const size_t n_x = std::max<size_t>(std::round(width / spacing), 1),
+                     n_y = std::max<size_t>(std::round(height / spacing), 1),
+                     n_clusters = n_x * n_y;
+
+        std::vector<float> center_x(n_clusters), center_y(n_clusters), center_values(n_clusters * n_planes);
+
+        const auto gradient = compute_gradient_magnitude(image);
+        for (size_t j = 0; j < n_y; ++j)
         {
-            for (size_t x = 0; x < seen.get_size().x(); ++x)
+            for (size_t i = 0; i < n_x; ++i)
             {
-                if (seen(x, y))
-                    continue;
+                long cx = (i + 0.5f) * width / float(n_x),
+                     cy = (j + 0.5f) * height / float(n_y);
+
+                long best_x = cx, best_y = cy;
+                for (long y = std::max<long>(cy - 1, 0); y <= std::min<long>(cy + 1, height - 1); ++y)
+                    for (long x = std::max<long>(cx - 1, 0); x <= std::min<long>(cx + 1, width - 1); ++x)
+                        if (float(gradient._data(x, y)) < float(gradient._data(best_x, best_y)))
+                            best_x = x, best_y = y;
+
+                const size_t k = i + j * n_x;
+                center_x[k] = best_x;
+                center_y[k] = best_y;
+                for (size_t p = 0; p < n_planes; ++p)
+                    center_values[k * n_planes + p] = values[(best_x + best_y * width) * n_planes + p];
+            }
+        }
+
+        // pixels are split into horizontal stripes, each stripe is updated by exactly one thread. Within a stripe, clusters are
+        // visited in a fixed order so the result does not depend on the number of threads
+        auto& pool = ThreadPool::get();
+        const size_t stripe_height = std::max<size_t>(window, 16);
+        const size_t n_stripes = (height + stripe_height - 1) / stripe_height;
+
+        std::vector<uint32_t> labels(n_pixels, 0), previous_labels;
+        std::vector<float> distances(n_pixels);
+
+        std::vector<std::vector<double>> stripe_sums(n_stripes, std::vector<double>(n_clusters * (n_planes + 2)));
+        std::vector<std::vector<size_t>> stripe_counts(n_stripes, std::vector<size_t>(n_clusters));
+
+        for (size_t iteration = 0; iteration < max_n_iterations; ++iteration)
+        {
+            std::atomic<size_t> n_changed = 0;
+            previous_labels = labels;
+
+            // assignment step: each cluster claims the pixels in its 2S x 2S window that are closer to it than to any previous cluster
+            pool.parallel_for(n_stripes, [&](size_t stripe_i)
+            {
+                const long y_begin = stripe_i * stripe_height,
+                           y_end = std::min<long>(height, y_begin + stripe_height);
+
+                std::fill(distances.begin() + y_begin * width, distances.begin() + y_end * width, std::numeric_limits<float>::max());
 
-                if (not bool(seen(x, y)))
+                for (size_t k = 0; k < n_clusters; ++k)
                 {
-                    color = image(x, y);
-                    segments.emplace_back();
+                    const long cy = std::lround(center_y[k]),
+                               cx = std::lround(center_x[k]);
+
+                    const long y_min = std::max(cy - window, y_begin),
+                               y_max = std::min(cy + window + 1, y_end);
+
+                    if (y_min >= y_max)
+                        continue;
 
-                    std::deque<Vector2ui> to_add;
-                    to_add.push_front(Vector2ui{x, y});
+                    const long x_min = std::max<long>(cx - window, 0),
+                               x_max = std::min<long>(cx + window + 1, width);
 
-                    while (not to_add.empty())
+                    const float* center_value = &center_values[k * n_planes];
+
+                    for (long y = y_min; y < y_max; ++y)
                     {
-                        auto current = to_add.front();
-                        for (int i : {-1, 1, 0, 0})
+                        const float dy = y - center_y[k];
+                        for (long x = x_min; x < x_max; ++x)
                         {
-                            for (int j : {0, 0, -1, 1})
+                            const size_t index = x + y * width;
+                            const float* value = &values[index * n_planes];
+
+                            float value_distance = 0;
+                            for (size_t p = 0; p < n_planes; ++p)
+                                value_distance += (value[p] - center_value[p]) * (value[p] - center_value[p]);
+
+                            const float dx = x - center_x[k];
+                            const float distance = value_distance + spatial_weight * (dx * dx + dy * dy);
+
+                            if (distance < distances[index])
                             {
-                                if (current.x() + i < 0 or current.x() + i >= seen.get_size().x() or
-                                    current.y() + j < 0 or current.y() + j >= seen.get_size().y() or
-                                    seen(current.x() + i, current.y() + j))
-                                    continue;
-
-                                if (image(current.x() + i, current.y() + j) == color)
-                                {
-                                    to_add.push_back(Vector2ui{current.x() + i, current.y() + j});
-                                    seen(current.x() + i, current.y() + j) = true;
-                                }
+                                distances[index] = distance;
+                                labels[index] = k;
                             }
                         }
-
-                        segments.back().insert(to_add.front());
-                        to_add.pop_front();
                     }
+                }
+            });
+
+            // update step: accumulate per stripe, then move each center to the mean of its pixels
+            pool.parallel_for(n_stripes, [&](size_t stripe_i)
+            {
+                auto& sums = stripe_sums[stripe_i];
+                auto& counts = stripe_counts[stripe_i];
+                std::fill(sums.begin(), sums.end(), 0);
+                std::fill(counts.begin(), counts.end(), 0);
+
+                const size_t y_begin = stripe_i * stripe_height,
+                             y_end = std::min(height, y_begin + stripe_height);
+
+                size_t n_stripe_changed = 0;
+                for (size_t y = y_begin; y < y_end; ++y)
+                {
+                    for (size_t x = 0; x < width; ++x)
+                    {
+                        const size_t index = x + y * width;
+                        const uint32_t k = labels[index];
+                        n_stripe_changed += k != previous_labels[index];
+                        double* sum = &sums[k * (n_planes + 2)];
 
-                    if (segments.back().size() < min_segment_size)
-                        segments.erase(segments.end() - 1);
+                        sum[0] += x;
+                        sum[1] += y;
+                        for (size_t p = 0; p < n_planes; ++p)
+                            sum[2 + p] += values[index * n_planes + p];
 
-                    color = false;
+                        counts[k] += 1;
+                    }
                 }
-            }
-        }
 
-        return segments;
-    }
-    
-    template<typename Inner_t>
-    BinaryImage manual_threshold(const Image<Inner_t, 1>& image, Inner_t threshold)
-    {
-        BinaryImage out;
-        out.create(image.get_size().x(), image.get_size().y());
+                n_changed.fetch_add(n_stripe_changed, std::memory_order_relaxed);
+            });
 
-        for (size_t x = 0; x < image.get_size().x(); ++x)
-            for (size_t y = 0; y < image.get_size().y(); ++y)
-                out(x, y) = image(x, y) > threshold;
+            pool.parallel_for_ranges(n_clusters, [&](size_t begin, size_t end)
+            {
+                for (size_t k = begin; k < end; ++k)
+                {
+                    double sum[n_planes + 2] = {0};
+                    size_t count = 0;
 
-        return out;
-    }
-    
-    template<typename Inner_t>
-    BinaryImage basic_threshold(const Image<Inner_t, 1>& image)
-    {
-        const float convergence_treshold = 1 / 255.f;
+                    for (size_t stripe_i = 0; stripe_i < n_stripes; ++stripe_i)
+                    {
+                        for (size_t p = 0; p < n_planes + 2; ++p)
+                            sum[p] += stripe_sums[stripe_i][k * (n_planes + 2) + p];
 
-        auto histogram = Histogram<256>();
-        histogram.create_from(image);
+                        count += stripe_counts[stripe_i][k];
+                    }
+
+                    if (count == 0)
+                        continue;
+
+                    center_x[k] = sum[0] / count;
+                    center_y[k] = sum[1] / count;
+                    for (size_t p = 0; p < n_planes; ++p)
+                        center_values[k * n_planes + p] = sum[2 + p] / count;
+                }
+            }, 64);
+
+            if (n_changed.load() * 1000 < n_pixels)
+                break;
+        }
 
-        uint8_t old_threshold = histogram.mean() * 255;
-        uint8_t new_threshold = 0;
-        float total_sum = 0,
-                left_sum = 0,
-                right_sum = 0;
+        // enforce connectivity: fragments smaller than a quarter of the expected superpixel size are merged into the
+        // component left of or above their first pixel, which always comes earlier in scan order
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                out._data(x, y).x() = labels[x + y * width];
 
-        size_t total_n = 0,
-                left_n = 0,
-                right_n = 0;
+        const auto components = label_connected_components(out, Connectivity::FOUR);
+        const size_t min_size = std::max<size_t>(spacing * spacing / 4, 1);
 
-        float left_mean, right_mean;
+        std::vector<uint32_t> component_to_label(components.statistics.size(), 0);
+        uint32_t n_labels = 0;
 
-        for (uint8_t i = 0; i < uint8_t(255); ++i)
+        for (uint32_t c = 1; c < components.statistics.size(); ++c)
         {
-            float value = histogram.at(i) * (i / 255.f);
-            if (i < old_threshold)
+            const auto& stats = components.statistics[c];
+
+            size_t first_x = stats.min.x(), first_y = stats.min.y();
+            while (components.labels._data(first_x, first_y).x() != c)
+                ++first_x;
+
+            if (stats.n_pixels < min_size and (first_x > 0 or first_y > 0))
             {
-                left_n += histogram.at(i);
-                left_sum += value;
+                const auto& neighbor = first_x > 0 ? components.labels._data(first_x - 1, first_y) : components.labels._data(first_x, first_y - 1);
+                component_to_label[c] = component_to_label[neighbor.x()];
             }
             else
-            {
-                right_n += histogram.at(i);
-                right_sum += value;
-            }
+                component_to_label[c] = n_labels++;
         }
 
-        left_mean = left_sum / left_n;
-        right_mean = right_sum / right_n;
-        new_threshold = (left_mean + 0.5 * (abs(right_mean - left_mean))) * 255;
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                out._data(x, y).x() = component_to_label[components.labels._data(x, y).x()];
+
+        return out;
+    }
+
+    template<typename Image_t>
+    Image_t superpixel_clustering(const Image_t& image, size_t n_superpixels, size_t max_n_iterations)
+    {
+        const auto labels = compute_superpixels(image, n_superpixels, 0.1, max_n_iterations);
+
+        uint32_t n_labels = 0;
+        for (size_t y = 0; y < labels.get_size().y(); ++y)
+            for (size_t x = 0; x < labels.get_size().x(); ++x)
+                n_labels = std::max<uint32_t>(n_labels, labels._data(x, y).x() + 1);
+
+        return detail::recolor_by_label(image, labels, n_labels);
+    }
 
-        while (std::abs<float>((old_threshold / 255.f) - (new_threshold / 255.f)) > convergence_treshold)
+    namespace detail
+    {
+        // queue over integer priorities in [0, n_levels), pops elements of lowest priority first and elements of equal priority in the order they were pushed
+        class HierarchicalQueue
         {
-            old_threshold = new_threshold;
-            left_n = 0;
-            left_sum = 0;
-            right_n = 0;
-            right_sum = 0;
+            public:
+                HierarchicalQueue(size_t n_levels)
+                    : _buckets(n_levels), _heads(n_levels, 0), _occupied((n_levels + 63) / 64, 0)
+                {}
 
-            for (uint8_t i = 0; i < uint8_t(255); ++i)
-            {
-                float value = histogram.at(i) * (i / 255.f);
-                if (i < old_threshold)
+                void push(uint32_t element, size_t priority)
                 {
-                    left_n += histogram.at(i);
-                    left_sum += value;
+                    _buckets[priority].push_back(element);
+                    _occupied[priority / 64] |= uint64_t(1) << (priority % 64);
+                    _current = std::min(_current, priority);
+                    _size += 1;
                 }
-                else
+
+                // undefined if empty
+                uint32_t pop()
+                {
+                    // levels below the current one are always empty, skip ahead to the next occupied level 64 levels at a time
+                    size_t word = _current / 64;
+                    uint64_t bits = _occupied[word] & (~uint64_t(0) << (_current % 64));
+
+                    while (bits == 0)
+                        bits = _occupied[++word];
+
+                    _current = word * 64 + std::countr_zero(bits);
+
+                    auto& bucket = _buckets[_current];
+                    const uint32_t out = bucket[_heads[_current]++];
+
+                    if (_heads[_current] == bucket.size())
+                    {
+                        bucket.clear();
+                        _heads[_current] = 0;
+                        _occupied[word] &= ~(uint64_t(1) << (_current % 64));
+                    }
+
+                    _size -= 1;
+                    return out;
+                }
+
+                // priority of the last popped element
+                size_t get_current_level() const
                 {
-                    right_n += histogram.at(i);
-                    right_sum += value;
+                    return _current;
                 }
-            }
 
-            left_mean = left_sum / left_n;
-            right_mean = right_sum / right_n;
-            new_threshold = (left_mean + 0.5 * (abs(right_mean - left_mean))) * 255;
-        }
+                bool empty() const
+                {
+                    return _size == 0;
+                }
 
-        auto out = BinaryImage();
-        out.create(image.get_size().x(), image.get_size().y());
+            private:
+                std::vector<std::vector<uint32_t>> _buckets;
+                std::vector<size_t> _heads;
+                std::vector<uint64_t> _occupied;
+                size_t _current = 0;
+                size_t _size = 0;
+        };
 
-        for (size_t x = 0; x < image.get_size().x(); ++x)
-            for (size_t y = 0; y < image.get_size().y(); ++y)
-                out(x, y) = image(x, y) > (new_threshold / 255.f);
+        // distances between a pixel and a regions mean are quantized to this many levels for the region growing queue
+        constexpr size_t region_growing_n_levels = 1 << 12;
 
-        return out;
+        // offsets of the 4- or 8-neighborhood, the first four are the 4-neighborhood
+        constexpr std::array<std::array<int, 2>, 8> neighborhood_offsets = {{
+            {-1, 0}, {1, 0}, {0, -1}, {0, 1},
+            {-1, -1}, {1, -1}, {-1, 1}, {1, 1}
+        }};
     }
-    
-    template<typename Inner_t>
-    BinaryImage otsu_threshold(const Image<Inner_t, 1>& image)
+
+    template<typename Image_t>
+    LabelImage seeded_region_growing(const Image_t& image, const LabelImage& seeds, Connectivity connectivity)
     {
-        auto histogram = Histogram<256>();
-        histogram.create_from(image);
+        using Value_t = typename Image_t::Value_t;
+        constexpr size_t n_planes = Value_t::size();
+        constexpr size_t n_levels = detail::region_growing_n_levels;
+
+        // pixel is in the queue but not yet part of a region
+        constexpr uint32_t queued = std::numeric_limits<uint32_t>::max();
 
-        std::map<uint8_t, std::pair<float, float>> threshold_to_sums;   // k: {cumulative_sum, intensity_sum}
-        float mn = image.get_size().x() * image.get_size().y();
-        float global_mean = 0;
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y(),
+                     n_neighbors = static_cast<size_t>(connectivity);
 
-        for (uint8_t k = 0; k < 255; ++k)
+        std::vector<uint32_t> labels(width * height, 0);
+        uint32_t n_labels = 1;
+
+        for (size_t y = 0; y < height; ++y)
         {
-            float cumulative_sum = 0;
-            float intensity_sum = 0;
-            size_t n = 0;
-            for (uint8_t i = 0; i <= k; ++i)
+            for (size_t x = 0; x < width; ++x)
             {
-                float p_i = histogram.at(i) / mn;
-                cumulative_sum += p_i;
-                intensity_sum += p_i * i;
-                n += histogram.at(i);
-
-                if (k == 254)
-                    global_mean += p_i * i;
+                labels[x + y * width] = seeds._data(x, y).x();
+                n_labels = std::max<uint32_t>(n_labels, seeds._data(x, y).x() + 1);
             }
-            threshold_to_sums.emplace(k, std::make_pair(cumulative_sum, intensity_sum));
         }
 
-        uint8_t max_k = 0;
-        float max_sigma = 0;
-        for (auto& pair : threshold_to_sums)
+        // running sums keep the mean of each region up to date in O(1) per added pixel
+        std::vector<double> sums(n_labels * n_planes, 0);
+        std::vector<float> means(n_labels * n_planes, 0);
+        std::vector<size_t> counts(n_labels, 0);
+
+        auto add_to_region = [&](size_t x, size_t y, uint32_t label)
         {
-            auto p_i = pair.second.first;
-            auto local_mean = pair.second.second;
-            auto sigma = pow(global_mean * p_i - local_mean, 2) / (p_i * (1 - p_i));
+            counts[label] += 1;
+            for (size_t i = 0; i < n_planes; ++i)
+            {
+                sums[label * n_planes + i] += image._data(x, y).at(i);
+                means[label * n_planes + i] = sums[label * n_planes + i] / counts[label];
+            }
+        };
 
-            if (sigma > max_sigma)
+        // euclidean distance normalized so values in [0, 1] result in distances in [0, 1]
+        auto distance = [&](size_t x, size_t y, uint32_t label) -> float
+        {
+            float out = 0;
+            for (size_t i = 0; i < n_planes; ++i)
             {
-                max_sigma = sigma;
-                max_k = pair.first;
+                const float difference = image._data(x, y).at(i) - means[label * n_planes + i];
+                out += difference * difference;
             }
-        }
 
-        float result = max_k / 255.f;
+            return std::sqrt(out / n_planes);
+        };
 
-        auto out = BinaryImage();
-        out.create(image.get_size().x(), image.get_size().y());
+        detail::HierarchicalQueue queue(n_levels);
 
-        for (size_t x = 0; x < image.get_size().x(); ++x)
-            for (size_t y = 0; y < image.get_size().y(); ++y)
-                out(x, y) = image(x, y) > result;
+        auto push_neighbors = [&](size_t x, size_t y, uint32_t label)
+        {
+            for (size_t n = 0; n < n_neighbors; ++n)
+            {
+                const long nx = long(x) + detail::neighborhood_offsets[n][0],
+                           ny = long(y) + detail::neighborhood_offsets[n][1];
 
-        return out;
-    }
-    
-    template<typename Inner_t>
-    BinaryImage variable_threshold(const Image<Inner_t, 1>& image, float tail_length_factor)
-    {
-        BinaryImage out;
-        out.create(image.get_size().x(), image.get_size().y());
+                if (nx < 0 or ny < 0 or nx >= long(width) or ny >= long(height) or labels[nx + ny * width] != 0)
+                    continue;
 
-        std::list<float> tail;
-        float current_sum = 0;
+                labels[nx + ny * width] = queued;
+                queue.push(nx + ny * width, std::min<size_t>(distance(nx, ny, label) * (n_levels - 1), n_levels - 1));
+            }
+        };
 
-        size_t tail_length = (image.get_size().x() + image.get_size().y()) * tail_length_factor;
-        size_t k = 0;
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                if (labels[x + y * width] != 0)
+                    add_to_region(x, y, labels[x + y * width]);
 
-        auto update = [&](size_t x, size_t y, size_t i) 
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                if (labels[x + y * width] != 0 and labels[x + y * width] != queued)
+                    push_neighbors(x, y, labels[x + y * width]);
+
+        while (not queue.empty())
         {
-            out(x, y) = image(x, y) > (current_sum / tail.size());
+            const size_t i = queue.pop(),
+                         x = i % width,
+                         y = i / width;
 
-            if (i > tail_length)
+            // join the neighboring region whose current mean is closest
+            uint32_t closest = 0;
+            float min_distance = std::numeric_limits<float>::infinity();
+
+            for (size_t n = 0; n < n_neighbors; ++n)
             {
-                current_sum -= tail.front();
-                tail.erase(tail.begin());
+                const long nx = long(x) + detail::neighborhood_offsets[n][0],
+                           ny = long(y) + detail::neighborhood_offsets[n][1];
+
+                if (nx < 0 or ny < 0 or nx >= long(width) or ny >= long(height))
+                    continue;
+
+                const uint32_t label = labels[nx + ny * width];
+                if (label == 0 or label == queued)
+                    continue;
+
+                const float current = distance(x, y, label);
+                if (current < min_distance)
+                {
+                    min_distance = current;
+                    closest = label;
+                }
             }
 
-            tail.emplace_back(image(x, y));
-            current_sum += tail.back();
-        };
+            labels[i] = closest;
+            add_to_region(x, y, closest);
+            push_neighbors(x, y, closest);
+        }
 
-        int top = 0,
-            bottom = image.get_size().x() - 1,
-            left = 0,
-            right = image.get_size().y() - 1;
+        LabelImage out;
+        out.create(width, height);
 
-        int direction = 1;
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                out._data(x, y).x() = labels[x + y * width];
 
-        while (top <= bottom and left <= right)
+        return out;
+    }
+
+    template<typename Image_t>
+    Image_t region_growing_clustering(const Image_t& image, BinaryImage seed_image)
+    {
+        using Value_t = typename Image_t::Value_t;
+
+        // touching seed pixels are merged into one seed
+        const auto seeds = label_connected_components(seed_image, Connectivity::EIGHT, typename BinaryImage::Value_t(false));
+        const auto labels = seeded_region_growing(image, seeds.labels);
+
+        auto out = detail::recolor_by_label(image, labels, seeds.get_n_components() + 1);
+
+        Value_t unclustered;
+        if constexpr (std::is_same_v<Value_t, RGB>)
+            unclustered = RGB(1, 0, 1);
+        else
+            unclustered = Value_t(0);
+
+        for (size_t y = 0; y < image.get_size().y(); ++y)
+            for (size_t x = 0; x < image.get_size().x(); ++x)
+                if (labels._data(x, y).x() == 0)
+                    out._data(x, y) = unclustered;
+
+        return out;
+    }
+
+    namespace detail
+    {
+        // gradient magnitudes are quantized to this many levels for watershed flooding
+        constexpr size_t watershed_n_levels = 1 << 16;
+
+        // quantize gradient magnitude of image into levels in [0, watershed_n_levels)
+        template<typename Image_t>
+        std::vector<uint16_t> compute_watershed_relief(const Image_t& image)
         {
-            if (direction == 1)
-            {
-                for (int i = left; i <= right; ++i, k++)
-                    update(top, i, k);
+            const auto gradient = compute_gradient_magnitude(image);
+            const size_t width = gradient.get_size().x(),
+                         height = gradient.get_size().y();
 
-                ++top;
-                direction = 2;
-            }
+            std::vector<uint16_t> relief(width * height);
+            for (size_t y = 0; y < height; ++y)
+                for (size_t x = 0; x < width; ++x)
+                    relief[x + y * width] = std::clamp(gradient._data(x, y).x(), 0.f, 1.f) * (watershed_n_levels - 1);
 
-            else if (direction == 2)
-            {
-                for (int i = top; i <= bottom; ++i, k++)
-                    update(i, right, k);
+            return relief;
+        }
 
-                --right;
-                direction = 3;
-            }
+        // flood relief starting at all labeled pixels, each unlabeled pixel takes the label of the neighbor that reached it first
+        // no pixel is reached before all pixels of lower level that are connected to a marker, so labels meet along the ridges of the relief
+        inline void flood_from_markers(const std::vector<uint16_t>& relief, std::vector<uint32_t>& labels, size_t width, size_t height, Connectivity connectivity)
+        {
+            const size_t n_neighbors = static_cast<size_t>(connectivity);
+            HierarchicalQueue queue(watershed_n_levels);
 
-            else if (direction == 3)
-            {
-                for (int i = right; i >= left; --i, k++)
-                    update(bottom, i, k);
+            for (size_t i = 0; i < labels.size(); ++i)
+                if (labels[i] != 0)
+                    queue.push(i, relief[i]);
 
-                --bottom;
-                direction = 4;
-            }
-            else if (direction == 4)
+            while (not queue.empty())
             {
-                for (int i = bottom; i >= top; --i)
-                    update(i, left, k);
+                const size_t i = queue.pop(),
+                             x = i % width,
+                             y = i / width,
+                             level = queue.get_current_level();
 
-                ++left;
-                direction = 1;
+                for (size_t n = 0; n < n_neighbors; ++n)
+                {
+                    const long nx = long(x) + neighborhood_offsets[n][0],
+                               ny = long(y) + neighborhood_offsets[n][1];
+
+                    if (nx < 0 or ny < 0 or nx >= long(width) or ny >= long(height))
+                        continue;
+
+                    const size_t j = nx + ny * width;
+                    if (labels[j] != 0)
+                        continue;
+
+                    // pixels below the current level are flooded at the current level, the queue never moves backwards
+                    labels[j] = labels[i];
+                    queue.push(j, std::max<size_t>(relief[j], level));
+                }
             }
         }
 
-        return out;
+        inline LabelImage to_label_image(const std::vector<uint32_t>& labels, size_t width, size_t height)
+        {
+            LabelImage out;
+            out.create(width, height);
+
+            for (size_t y = 0; y < height; ++y)
+                for (size_t x = 0; x < width; ++x)
+                    out._data(x, y).x() = labels[x + y * width];
+
+            return out;
+        }
     }
-    
-    template<typename Inner_t>
-    BinaryImage neighborhood_threshold(const Image<Inner_t, 1>& image, size_t neighborhood_size)
+
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t& image, const LabelImage& markers, Connectivity connectivity)
+    {
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y();
+
+        std::vector<uint32_t> labels(width * height);
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                labels[x + y * width] = markers._data(x, y).x();
+
+        detail::flood_from_markers(detail::compute_watershed_relief(image), labels, width, height, connectivity);
+        return detail::to_label_image(labels, width, height);
+    }
+
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t& image, const BinaryImage& markers, Connectivity connectivity)
+    {
+        // touching marker pixels are merged into one marker
+        const auto components = label_connected_components(markers, Connectivity::EIGHT, typename BinaryImage::Value_t(false));
+        return watershed_segmentation(image, components.labels, connectivity);
+    }
+
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t& image, Connectivity connectivity)
     {
-        auto out = BinaryImage();
-        out.create(image.get_size().x(), image.get_size().y());
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y(),
+                     n_neighbors = static_cast<size_t>(connectivity);
 
-        const int spread = 7;
-        const int half_spread = spread * 0.5;
+        const auto relief = detail::compute_watershed_relief(image);
 
-        for (size_t x = 0; x < image.get_size().x(); ++x)
+        // plateaus of equal level
+        LabelImage levels;
+        levels.create(width, height);
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                levels._data(x, y).x() = relief[x + y * width];
+
+        const auto plateaus = label_connected_components(levels, connectivity);
+
+        // a plateau is a regional minimum if none of its pixels has a lower neighbor
+        std::vector<bool> is_minimum(plateaus.statistics.size(), true);
+        for (size_t y = 0; y < height; ++y)
         {
-            for (size_t y = 0; y < image.get_size().y(); ++y)
+            for (size_t x = 0; x < width; ++x)
             {
-                float mean = 0;
-                size_t count = 0;
-                for (size_t i = 1; i <= spread * neighborhood_size; i += spread)
+                for (size_t n = 0; n < n_neighbors; ++n)
                 {
-                    mean += image(x - i, y);
-                    mean += image(x + i, y);
-                    mean += image(x, y + i);
-                    mean += image(x, y - i);
+                    const long nx = long(x) + detail::neighborhood_offsets[n][0],
+                               ny = long(y) + detail::neighborhood_offsets[n][1];
 
-                    mean += image(x - i - half_spread, y - i - half_spread);
-                    mean += image(x + i - half_spread, y - i - half_spread);
-                    mean += image(x - i - half_spread, y + i - half_spread);
-                    mean += image(x + i - half_spread, y + i - half_spread);
+                    if (nx >= 0 and ny >= 0 and nx < long(width) and ny < long(height) and relief[nx + ny * width] < relief[x + y * width])
+                    {
+                        is_minimum[plateaus.labels._data(x, y).x()] = false;
+                        break;
+                    }
                 }
-                mean /= (8 * neighborhood_size);
-                out(x, y) = float(image(x, y)) < mean;
             }
         }
 
-        return out;
+        // minima are numbered in order of their first pixel
+        std::vector<uint32_t> plateau_to_label(plateaus.statistics.size(), 0);
+        uint32_t n_labels = 0;
+        for (size_t plateau = 1; plateau < plateaus.statistics.size(); ++plateau)
+            if (is_minimum[plateau])
+                plateau_to_label[plateau] = ++n_labels;
+
+        std::vector<uint32_t> labels(width * height);
+        for (size_t y = 0; y < height; ++y)
+            for (size_t x = 0; x < width; ++x)
+                labels[x + y * width] = plateau_to_label[plateaus.labels._data(x, y).x()];
+
+        detail::flood_from_markers(relief, labels, width, height, connectivity);
+        return detail::to_label_image(labels, width, height);
     }
 
-    template<typename T, size_t N>
-    Texture<T, N> threshold(const Texture<T, N>& texture, size_t neighborhood_size, size_t correction)
+    namespace detail
     {
-        assert(neighborhood_size > 0);
+        // edge weights are quantized to 16 bit so edges can be sorted with a single counting sort pass
+        constexpr size_t graph_segmentation_n_levels = 1 << 16;
+    }
 
-        auto out = texture;
+    template<typename Image_t>
+    LabelImage felzenszwalb_segmentation(const Image_t& image, float k, size_t min_size, Connectivity connectivity)
+    {
+        using Value_t = typename Image_t::Value_t;
+        constexpr size_t n_planes = Value_t::size();
+        constexpr size_t n_levels = detail::graph_segmentation_n_levels;
+        constexpr uint32_t invalid = std::numeric_limits<uint32_t>::max();
 
-        auto shader = State::register_shader("local_threshold.glsl");
-        auto program = State::register_program(shader);
-        State::bind_shader_program(program);
-        State::free_shader(shader);
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y(),
+                     n_pixels = width * height;
 
-        State::set_uint(program, "_neighborhood_size", neighborhood_size);
-        State::set_uint(program, "_correction", correction);
+        // pixels are addressed with 32 bit in the union-find
+        assert(n_pixels < invalid);
 
-        auto& workspace = out.get_workspace();
-        workspace.display();
-        workspace.yield();
+        // each pixel owns the edges to its right, lower, lower right and lower left neighbor, in that order
+        constexpr std::array<std::array<int, 2>, 4> directions = {{{1, 0}, {0, 1}, {1, 1}, {-1, 1}}};
+        const size_t n_directions = connectivity == Connectivity::FOUR ? 2 : 4;
 
-        return out;
-    }
+        // quantized euclidean distance between the values of both pixels, edges leaving the image are invalid
+        std::vector<uint32_t> weights(n_pixels * n_directions, invalid);
+        ThreadPool::get().parallel_for_ranges(height, [&](size_t y_begin, size_t y_end){
+            for (size_t y = y_begin; y < y_end; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    for (size_t d = 0; d < n_directions; ++d)
+                    {
+                        const long nx = long(x) + directions[d][0],
+                                   ny = long(y) + directions[d][1];
 
-    template<typename Image_t>
-    Image_t superpixel_clustering(const Image_t& image, size_t n_superpixels, size_t max_n_iterations)
-    {
-        const size_t n_pixels = image.get_size().x() * image.get_size().y();
-        auto spacing = sqrt(n_pixels / double(n_superpixels));
+                        if (nx < 0 or nx >= long(width) or ny >= long(height))
+                            continue;
 
-        using Value_t = typename Image_t::Value_t;
-        auto value_distance = [&](const Value_t& a, const Value_t& b) -> float
-        {
-            float distance = 0;
-            for (size_t i = 0; i < Value_t::size(); ++i)
-                distance += fabs(a.at(i) - b.at(i));
+                        float distance = 0;
+                        for (size_t i = 0; i < n_planes; ++i)
+                        {
+                            const float difference = image._data(x, y).at(i) - image._data(nx, ny).at(i);
+                            distance += difference * difference;
+                        }
+
+                        distance = std::sqrt(distance / n_planes);
+                        weights[(x + y * width) * n_directions + d] = std::min<size_t>(distance * (n_levels - 1), n_levels - 1);
+                    }
+                }
+            }
+        }, 16);
 
-            return distance;
+        // union-find over pixels, each root stores the size of its component and the threshold Int(C) + k / |C|.
+        // Edges are processed in ascending order so Int(C), the heaviest edge of the components minimum spanning tree, is the weight of the edge that merged it last
+        struct Node
+        {
+            uint32_t parent;
+            uint32_t size;
+            float threshold;
         };
 
-        auto xy_distance = [&](const auto& a, const auto& b) -> float
+        // filled once the edge weights are freed, to keep peak memory down
+        std::vector<Node> nodes;
+
+        auto find = [&](uint32_t i) -> uint32_t
         {
-            float distance = 0;
-            distance += fabs(a.x() - b.x());
-            distance += fabs(a.y() - b.y());
+            // path halving
+            while (nodes[i].parent != i)
+            {
+                nodes[i].parent = nodes[nodes[i].parent].parent;
+                i = nodes[i].parent;
+            }
 
-            return distance / (2 * spacing * spacing);
+            return i;
         };
 
-        struct Cluster
+        auto merge = [&](uint32_t a, uint32_t b, float weight)
         {
-            const Vector2f initial_center;
-            Vector2f center;
-            Value_t color_sum;
-            Vector2f xy_sum;
-            int n;
-        };
+            if (nodes[a].size < nodes[b].size)
+                std::swap(a, b);
 
-        std::unordered_map<size_t, Cluster> clusters;
+            nodes[b].parent = a;
+            nodes[a].size += nodes[b].size;
+            nodes[a].threshold = weight + k / nodes[a].size;
+        };
 
-        auto distance = [&](const Vector2i& pos, size_t cluster_i)
+        auto get_endpoints = [&](size_t e) -> std::pair<uint32_t, uint32_t>
         {
-            if (cluster_i == -1)
-                return std::numeric_limits<float>::max();
+            const size_t i = e / n_directions,
+                         d = e % n_directions;
 
-            auto& cluster = clusters.at(cluster_i);
-            auto cluster_xy = cluster.xy_sum;
-            cluster_xy = cluster_xy / float(cluster.n);
+            return {i, i + directions[d][0] + directions[d][1] * width};
+        };
 
-            auto cluster_v = cluster.color_sum;
-            cluster_v = cluster_v / float(cluster.n);
+        // edge ids are 32 bit to halve the memory of sorting them, unless there are more edges than that can address
+        auto merge_along_edges = [&](auto edge_id)
+        {
+            using Edge_t = decltype(edge_id);
 
-            return xy_distance(pos, cluster_xy) + 2 * value_distance(image(pos.x(), pos.y()), cluster_v);
-        };
+            // counting sort by weight, stable so edges of equal weight stay in scan order
+            std::vector<size_t> offsets(n_levels + 1, 0);
+            for (auto weight : weights)
+                if (weight != invalid)
+                    offsets[weight + 1] += 1;
 
-        auto out = image;
-        auto gradient_img = compute_gradient_magnitude(image);
+            for (size_t i = 1; i <= n_levels; ++i)
+                offsets[i] += offsets[i - 1];
 
-        float per_row = ceil(sqrt(n_superpixels));
-        spacing = std::max(image.get_size().x() / per_row, image.get_size().y() / per_row);
-        spacing = ceil(spacing);
+            std::vector<Edge_t> edges(offsets.back());
+            for (size_t e = 0; e < weights.size(); ++e)
+                if (weights[e] != invalid)
+                    edges[offsets[weights[e]]++] = e;
 
-        // initialize
-        size_t n_total = 0;
-        for (size_t ii = 0, index = 0; ii < per_row; ii++)
-        {
-            for (size_t jj = 0; jj < per_row; jj++, index++)
-            {
-                auto i = ii * spacing;
-                auto j = jj * spacing;
+            // offsets[w] now points past the last edge of weight w, weights are implied by the position of each edge from here on
+            std::vector<uint32_t>().swap(weights);
 
-                auto center = Vector2f{float(i + spacing * 0.5), float(j + spacing * 0.5)};
-                auto cluster = Cluster{center, center, image(center.x(), center.y()), center, 1};
+            nodes.resize(n_pixels);
+            for (size_t i = 0; i < n_pixels; ++i)
+                nodes[i] = Node{uint32_t(i), 1, k};
 
-                size_t min_x = cluster.center.x(), min_y = cluster.center.y();
-                float min_gradient_value = std::numeric_limits<float>::max();
+            // edges between different components that were not merged, only these can be used to merge small components later
+            std::vector<Edge_t> rejected;
 
-                for (size_t x = i; x < i + spacing; ++x)
+            for (size_t level = 0; level < n_levels; ++level)
+            {
+                const float weight = level / float(n_levels - 1);
+                for (size_t position = level == 0 ? 0 : offsets[level - 1]; position < offsets[level]; ++position)
                 {
-                    for (size_t y = j; y < j + spacing; ++y)
-                    {
-                        if (x < 0 or x >= image.get_size().x() or y < 0 or y >= image.get_size().y())
-                            continue;
+                    const auto [i, j] = get_endpoints(edges[position]);
+                    const uint32_t a = find(i),
+                                   b = find(j);
 
-                        out(x, y).at(0) = index;
-                        cluster.xy_sum += Vector2f{float(x), float(y)};
-                        cluster.color_sum += image(x, y);
-                        cluster.n += 1;
-                        n_total += 1;
-
-                        float gradient = gradient_img(x, y);
-                        if (gradient < min_gradient_value)
-                        {
-                            min_x = x;
-                            min_y = y;
+                    if (a == b)
+                        continue;
 
-                            min_gradient_value = gradient;
-                        }
-                    }
+                    if (weight <= nodes[a].threshold and weight <= nodes[b].threshold)
+                        merge(a, b, weight);
+                    else if (min_size > 1)
+                        rejected.push_back(edges[position]);
                 }
-
-                cluster.center = Vector2f{float(min_x), float(min_y)};
-                clusters.insert(std::make_pair(index, std::move(cluster)));
             }
-        }
 
-        assert(n_total == n_pixels);
-
-        size_t n_changed = n_pixels;
-        size_t n_iterations = 0;
-        while (n_changed > 0 and n_iterations < max_n_iterations)
-        {
-            n_changed = 0;
-            for (auto& pair : clusters)
+            // components below the minimum size are merged along the lightest edges leaving them
+            for (auto e : rejected)
             {
-                auto& cluster = pair.second;
-                auto cluster_i = pair.first;
-
-                const float offset = 0.75 * spacing;
-                int x_range_min = std::min(cluster.initial_center.x(), cluster.center.x()) - offset;
-                int x_range_max = std::max(cluster.initial_center.x(), cluster.center.x()) + offset;
-                int y_range_min = std::min(cluster.initial_center.y(), cluster.center.y()) - offset;
-                int y_range_max = std::max(cluster.initial_center.y(), cluster.center.y()) + offset;
-
-                for (int y = y_range_min; y < y_range_max; ++y)
-                {
-                    for (int x = x_range_min; x < x_range_max; ++x)
-                    {
-                        if (x < 0 or x >= image.get_size().x() or y < 0 or y >= image.get_size().y())
-                            continue;
+                const auto [i, j] = get_endpoints(e);
+                const uint32_t a = find(i),
+                               b = find(j);
 
-                        size_t old_i = out(x, y).at(0);
+                if (a != b and (nodes[a].size < min_size or nodes[b].size < min_size))
+                    merge(a, b, 0);
+            }
+        };
 
-                        if (old_i == cluster_i)
-                            continue;
+        if (weights.size() <= std::numeric_limits<uint32_t>::max())
+            merge_along_edges(uint32_t());
+        else
+            merge_along_edges(size_t());
 
-                        float old_dist = distance(Vector2i{x, y}, old_i);
-                        float new_dist = distance(Vector2i{x, y}, cluster_i);
+        // number components in order of their first pixel
+        std::vector<uint32_t> root_to_label(n_pixels, invalid);
+        uint32_t n_labels = 0;
 
-                        if (new_dist < old_dist)
-                        {
-                            n_changed += 1;
-                            out(x, y).at(0) = float(cluster_i);
+        LabelImage out;
+        out.create(width, height);
 
-                            cluster.color_sum += image(x, y);
-                            cluster.xy_sum += Vector2f{float(x), float(y)};
-                            cluster.n += 1;
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width; ++x)
+            {
+                const uint32_t root = find(x + y * width);
+                if (root_to_label[root] == invalid)
+                    root_to_label[root] = n_labels++;
 
-                            auto& old_cluster = clusters.at(old_i);
-                            if (old_cluster.n > 0)
-                            {
-                                old_cluster.color_sum -= image(x, y);
-                                old_cluster.xy_sum -= Vector2f{float(x), float(y)};
-                                old_cluster.n -= 1;
-                            }
-                        }
-                    }
-                }
+                out._data(x, y).x() = root_to_label[root];
             }
-
-            n_iterations++;
         }
 
-        // post process
-        std::vector<Value_t> final_colors;
-        final_colors.resize(clusters.size());
+        return out;
+    }
 
-        for (auto& c : clusters)
-        {
-            if (c.second.n < 0)
-                c.second.n = 1;
+    namespace detail
+    {
+        // grayscale values are quantized to 16 bit for histogram-domain k-means
+        constexpr size_t k_means_n_gray_bins = size_t(1) << 16;
 
-            auto color = c.second.color_sum;
-            color = color / float(c.second.n);
-            final_colors.at(c.first) = color;
-        }
+        // bits per channel of the quantized color histogram
+        constexpr size_t k_means_n_color_bits = 6;
 
-        // merge
-        size_t n_merged = 0;
-        for (size_t i = 0; i < final_colors.size(); ++i)
+        inline size_t to_k_means_gray_bin(float value)
         {
-            for (size_t j = 0; j < final_colors.size(); ++j)
-            {
-                if (i == j)
-                    continue;
+            return size_t(std::round(std::clamp(value, 0.f, 1.f) * (k_means_n_gray_bins - 1)));
+        }
 
-                if (final_colors.at(i) == final_colors.at(j))
-                    continue;
+        inline size_t to_k_means_color_bin(const RGB& color)
+        {
+            constexpr size_t n_levels = size_t(1) << k_means_n_color_bits;
 
-                if (value_distance(final_colors.at(i), final_colors.at(j)) < 0.01)
-                {
-                    n_merged++;
-                    Value_t new_color = final_colors.at(i);
-                    new_color += final_colors.at(j);
+            auto quantize = [](float value) -> size_t {
+                return std::min<size_t>(std::clamp(value, 0.f, 1.f) * n_levels, n_levels - 1);
+            };
 
-                    new_color /= 2.f;
-                    final_colors.at(i) = new_color;
-                    final_colors.at(j) = new_color;
-                }
-            }
+            return (quantize(color.red()) << (2 * k_means_n_color_bits)) | (quantize(color.green()) << k_means_n_color_bits) | quantize(color.blue());
         }
 
-        for (auto& px : out)
-            px = final_colors.at(px.at(0));
+        // seed for the random number engines used by k-means, fixed so results are reproducible
+        constexpr size_t k_means_seed = 1234;
 
-        return out;
-    }
+        // points are split into chunks of fixed size for parallel k-means so per-chunk sums are reduced the same way for any number of threads
+        constexpr size_t k_means_chunk_size = 1 << 12;
 
-    template<typename Image_t>
-    Image_t k_means_clustering(const Image_t& image, size_t n_clusters, size_t max_n_iterations)
-    {
-        assert(false && "k-means clusterin in n dimensions is not currently supportly. Please convert you image to color or grayscale");
-    }
+        using KMeansPoint = std::array<float, 3>;
 
-    template<>
-    GrayScaleImage k_means_clustering<GrayScaleImage>(const GrayScaleImage& image, size_t n_clusters, size_t max_n_iterations)
-    {
-        struct Cluster
+        inline float squared_distance(const KMeansPoint& a, const KMeansPoint& b)
         {
-           float color_sum;
-           size_t n;
-           float mean_color;
-        };
+            const float x = a[0] - b[0],
+                        y = a[1] - b[1],
+                        z = a[2] - b[2];
 
-        std::vector<Cluster> clusters;
-        std::map<int, size_t> intensity_histogram;
+            return x * x + y * y + z * z;
+        }
 
-        for (long x = 0; x < image.get_size().x(); ++x)
+        // closest and second closest center, distances are euclidean
+        inline void find_two_closest_centers(const KMeansPoint& point, const std::vector<KMeansPoint>& centers, uint32_t& closest, float& closest_distance, float& second_distance)
         {
-            for (long y = 0; y < image.get_size().y(); ++y)
+            closest = 0;
+            closest_distance = std::numeric_limits<float>::infinity();
+            second_distance = std::numeric_limits<float>::infinity();
+
+            for (uint32_t c = 0; c < centers.size(); ++c)
             {
-                int value = int(image(x, y) * 255.f);
-                if (intensity_histogram.find(value) == intensity_histogram.end())
-                    intensity_histogram.emplace(value, 1);
-                else
-                    intensity_histogram.at(value) += 1;
+                const float distance = squared_distance(point, centers[c]);
+                if (distance < closest_distance)
+                {
+                    second_distance = closest_distance;
+                    closest_distance = distance;
+                    closest = c;
+                }
+                else if (distance < second_distance)
+                    second_distance = distance;
             }
-        }
 
-        std::vector<std::pair<int, size_t>> as_vector;
-        for (auto& pair : intensity_histogram)
-            as_vector.emplace_back(pair.first, pair.second);
+            closest_distance = std::sqrt(closest_distance);
+            second_distance = std::sqrt(second_distance);
+        }
 
-        int interval = int(as_vector.size() / float(n_clusters));
-        for (size_t i = 0; i < n_clusters; ++i)
+        // k-means++ seeding, each new center is drawn with probability proportional to weight times squared distance to the closest center so far
+        // returns less than n_clusters centers if there are less distinct points
+        inline std::vector<KMeansPoint> k_means_plus_plus(const std::vector<KMeansPoint>& points, const std::vector<size_t>& weights, size_t n_clusters, std::mt19937& engine)
         {
-            int max_intensity = i * interval;
-            size_t max_intensity_n = 0;
+            std::vector<KMeansPoint> centers;
+            if (points.empty() or n_clusters == 0)
+                return centers;
+
+            const size_t n_chunks = (points.size() + k_means_chunk_size - 1) / k_means_chunk_size;
+
+            std::vector<double> probabilities(weights.begin(), weights.end());
+            std::vector<float> min_distance(points.size(), std::numeric_limits<float>::infinity());
 
-            for (int j = i * interval; j < as_vector.size() and j < (i + 1) * interval; ++j)
+            while (centers.size() < n_clusters)
             {
-                if (as_vector.at(j).second > max_intensity_n)
-                {
-                    max_intensity = as_vector.at(j).first;
-                    max_intensity_n = as_vector.at(j).second;
-                }
+                std::discrete_distribution<size_t> distribution(probabilities.begin(), probabilities.end());
+                centers.push_back(points[distribution(engine)]);
+
+                const auto& center = centers.back();
+                ThreadPool::get().parallel_for(n_chunks, [&](size_t chunk){
+                    for (size_t i = chunk * k_means_chunk_size; i < std::min(points.size(), (chunk + 1) * k_means_chunk_size); ++i)
+                    {
+                        min_distance[i] = std::min(min_distance[i], squared_distance(points[i], center));
+                        probabilities[i] = double(weights[i]) * min_distance[i];
+                    }
+                });
+
+                if (std::all_of(probabilities.begin(), probabilities.end(), [](double p){ return p == 0; }))
+                    break;
             }
 
-            clusters.emplace_back(Cluster{max_intensity / 255.f, 1, max_intensity / 255.f});
+            return centers;
         }
 
-        auto dist = [](float a, float b) -> int
+        // Hamerly's k-means on weighted points, modifies centers in place and returns the index of each points center
+        // upper and lower bounds on the distance to the closest and second closest center skip most distance computations once centers settle
+        inline std::vector<uint32_t> hamerly_k_means(const std::vector<KMeansPoint>& points, const std::vector<size_t>& weights, std::vector<KMeansPoint>& centers, size_t max_n_iterations)
         {
-            return abs(int(a * 255) - int(b * 255));
-        };
+            const size_t n_points = points.size(),
+                         n_clusters = centers.size(),
+                         n_chunks = (n_points + k_means_chunk_size - 1) / k_means_chunk_size;
 
-        GrayScaleImage out;
-        out.create(image.get_size().x(), image.get_size().y());
+            std::vector<uint32_t> assignment(n_points, 0);
+            std::vector<float> upper(n_points), lower(n_points);
 
-        size_t n_changed = 1;
-        size_t n_iterations = 0;
-        while (n_changed != 0)
-        {
-            n_changed = 0;
-            for (long x = 0; x < image.get_size().x(); ++x)
+            // changes to the cluster sums are accumulated per chunk and reduced in chunk order
+            struct Accumulator
+            {
+                std::vector<std::array<double, 3>> sums;
+                std::vector<int64_t> counts;
+                size_t n_changed;
+            };
+
+            std::vector<Accumulator> accumulators(n_chunks);
+            std::vector<std::array<double, 3>> sums(n_clusters, {0, 0, 0});
+            std::vector<int64_t> counts(n_clusters, 0);
+
+            std::vector<float> half_separation(n_clusters), drift(n_clusters, 0);
+            float max_drift = 0, second_max_drift = 0;
+            uint32_t max_drift_cluster = 0;
+
+            for (size_t n_iterations = 0; ; ++n_iterations)
             {
-                for (long y = 0; y < image.get_size().y(); ++y)
+                // a point closer to its center than half the distance to the next center can not be closer to any other center
+                for (size_t c = 0; c < n_clusters; ++c)
                 {
                     float min_distance = std::numeric_limits<float>::infinity();
-                    size_t min_cluster_i = -1;
+                    for (size_t other = 0; other < n_clusters; ++other)
+                        if (other != c)
+                            min_distance = std::min(min_distance, squared_distance(centers[c], centers[other]));
+
+                    half_separation[c] = 0.5f * std::sqrt(min_distance);
+                }
 
-                    for (size_t i = 0; i < clusters.size(); ++i)
+                ThreadPool::get().parallel_for(n_chunks, [&](size_t chunk){
+                    auto& accumulator = accumulators[chunk];
+                    accumulator.sums.assign(n_clusters, {0, 0, 0});
+                    accumulator.counts.assign(n_clusters, 0);
+                    accumulator.n_changed = 0;
+
+                    auto move = [&](size_t i, uint32_t from, uint32_t to)
                     {
-                        auto current_distance = dist(image(x, y), clusters.at(i).mean_color);
-                        if (current_distance < min_distance)
+                        for (size_t j = 0; j < 3; ++j)
                         {
-                            min_distance = current_distance;
-                            min_cluster_i = i;
+                            accumulator.sums[from][j] -= double(weights[i]) * points[i][j];
+                            accumulator.sums[to][j] += double(weights[i]) * points[i][j];
                         }
-                    }
 
-                    int old_i = int(out(x, y));
+                        accumulator.counts[from] -= weights[i];
+                        accumulator.counts[to] += weights[i];
+                        accumulator.n_changed += 1;
+                    };
 
-                    if (old_i < 0 or old_i >= clusters.size())
+                    for (size_t i = chunk * k_means_chunk_size; i < std::min(n_points, (chunk + 1) * k_means_chunk_size); ++i)
                     {
-                        out(x, y) = min_cluster_i;
-                        clusters.at(min_cluster_i).n += 1;
-                        clusters.at(min_cluster_i).color_sum += image(x, y);
+                        uint32_t closest;
 
-                        if (n_iterations > 0)
+                        if (n_iterations == 0)
                         {
-                        clusters.at(min_cluster_i).mean_color = clusters.at(min_cluster_i).color_sum;
-                        clusters.at(min_cluster_i).mean_color /= clusters.at(min_cluster_i).n;
-                        }
+                            find_two_closest_centers(points[i], centers, closest, upper[i], lower[i]);
+                            assignment[i] = closest;
 
-                        n_changed++;
-                    }
-                    else if (out(x, y) != float(min_cluster_i))
-                    {
-                        auto before_dist = dist(clusters.at(old_i).mean_color, clusters.at(min_cluster_i).mean_color);
+                            for (size_t j = 0; j < 3; ++j)
+                                accumulator.sums[closest][j] += double(weights[i]) * points[i][j];
+
+                            accumulator.counts[closest] += weights[i];
+                            continue;
+                        }
 
-                        clusters.at(old_i).n -= 1;
-                        clusters.at(old_i).color_sum -= image(x, y);
-                        clusters.at(old_i).mean_color = clusters.at(old_i).color_sum;
-                        clusters.at(old_i).mean_color /= clusters.at(old_i).n;
+                        const uint32_t current = assignment[i];
+                        upper[i] += drift[current];
+                        lower[i] -= current == max_drift_cluster ? second_max_drift : max_drift;
 
-                        out(x, y) = min_cluster_i;
+                        const float bound = std::max(half_separation[current], lower[i]);
+                        if (upper[i] <= bound)
+                            continue;
 
-                        clusters.at(min_cluster_i).n += 1;
-                        clusters.at(min_cluster_i).color_sum += image(x, y);
+                        upper[i] = std::sqrt(squared_distance(points[i], centers[current]));
+                        if (upper[i] <= bound)
+                            continue;
 
-                        if (n_iterations > 0)
+                        find_two_closest_centers(points[i], centers, closest, upper[i], lower[i]);
+                        if (closest != current)
                         {
-                            clusters.at(min_cluster_i).mean_color = clusters.at(min_cluster_i).color_sum;
-                            clusters.at(min_cluster_i).mean_color /= clusters.at(min_cluster_i).n;
+                            move(i, current, closest);
+                            assignment[i] = closest;
                         }
+                    }
+                });
 
-                        auto after_dist = dist(clusters.at(old_i).mean_color, clusters.at(min_cluster_i).mean_color);
+                size_t n_changed = 0;
+                for (const auto& accumulator : accumulators)
+                {
+                    for (size_t c = 0; c < n_clusters; ++c)
+                    {
+                        for (size_t j = 0; j < 3; ++j)
+                            sums[c][j] += accumulator.sums[c][j];
 
-                        if (abs(after_dist - before_dist) > 0)
-                            n_changed++;
+                        counts[c] += accumulator.counts[c];
                     }
+
+                    n_changed += accumulator.n_changed;
                 }
-            }
 
-            if (n_iterations == 0)
-            {
-                for (auto& cluster : clusters)
-                    cluster.mean_color = cluster.color_sum / cluster.n;
+                if ((n_iterations > 0 and n_changed == 0) or n_iterations >= max_n_iterations)
+                    break;
+
+                // empty clusters keep their center
+                max_drift = 0;
+                second_max_drift = 0;
+                for (uint32_t c = 0; c < n_clusters; ++c)
+                {
+                    if (counts[c] <= 0)
+                    {
+                        drift[c] = 0;
+                        continue;
+                    }
+
+                    const auto old = centers[c];
+                    for (size_t j = 0; j < 3; ++j)
+                        centers[c][j] = sums[c][j] / counts[c];
+
+                    drift[c] = std::sqrt(squared_distance(old, centers[c]));
+                    if (drift[c] > max_drift)
+                    {
+                        second_max_drift = max_drift;
+                        max_drift = drift[c];
+                        max_drift_cluster = c;
+                    }
+                    else if (drift[c] > second_max_drift)
+                        second_max_drift = drift[c];
+                }
             }
 
-            n_iterations++;
+            return assignment;
         }
 
-        for (size_t i = 0; i < clusters.size(); ++i)
+        // assign each cell of the quantized color histogram to the center closest to the cell's midpoint
+        inline std::vector<uint32_t> compute_color_bin_lut(const std::vector<KMeansPoint>& centers)
         {
-            for (size_t j = 0; j < clusters.size(); ++j)
-            {
-                if (i == j)
-                    continue;
+            constexpr size_t n_levels = size_t(1) << k_means_n_color_bits,
+                             n_bins = n_levels * n_levels * n_levels;
 
-                // pseudo merge
-                if (dist(clusters.at(i).mean_color, clusters.at(j).mean_color) < 1)
+            std::vector<uint32_t> lut(n_bins);
+            ThreadPool::get().parallel_for_ranges(n_bins, [&](size_t begin, size_t end){
+                for (size_t bin = begin; bin < end; ++bin)
                 {
-                    size_t new_n = clusters.at(i).n + clusters.at(j).n;
-                    float new_sum = clusters.at(i).color_sum + clusters.at(j).color_sum;
-                    clusters.at(i).color_sum = new_sum;
-                    clusters.at(i).n = new_n;
-                    clusters.at(i).mean_color = new_sum;
-                    clusters.at(i).mean_color /= clusters.at(i).n;
-
-                    clusters.at(j).color_sum = new_sum;
-                    clusters.at(j).n = new_n;
-                    clusters.at(j).mean_color = new_sum;
-                    clusters.at(j).mean_color /= clusters.at(j).n;
+                    const KMeansPoint midpoint = {
+                        ((bin >> (2 * k_means_n_color_bits)) + 0.5f) / n_levels,
+                        (((bin >> k_means_n_color_bits) & (n_levels - 1)) + 0.5f) / n_levels,
+                        ((bin & (n_levels - 1)) + 0.5f) / n_levels
+                    };
+
+                    uint32_t closest;
+                    float closest_distance, second_distance;
+                    find_two_closest_centers(midpoint, centers, closest, closest_distance, second_distance);
+                    lut[bin] = closest;
                 }
-            }
-        }
+            }, k_means_chunk_size);
 
-        for (auto& px : out)
-        {
-            px = clusters.at(px).mean_color;
+            return lut;
         }
+    }
 
-        return out;
+    template<typename Image_t>
+    Image_t k_means_clustering(const Image_t& image, size_t n_clusters, size_t max_n_iterations)
+    {
+        assert(false && "k-means clusterin in n dimensions is not currently supportly. Please convert you image to color or grayscale");
     }
 
     template<>
-    ColorImage k_means_clustering<ColorImage>(const ColorImage& image, size_t n_clusters, size_t max_n_iterations)
+    inline GrayScaleImage k_means_clustering<GrayScaleImage>(const GrayScaleImage& image, size_t n_clusters, size_t max_n_iterations)
     {
-         // initial clusters
-        struct Cluster
-        {
-           RGB color_sum;
-           size_t n;
+        constexpr size_t n_bins = detail::k_means_n_gray_bins;
 
-           RGB mean_color;
-        };
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y();
 
-        std::vector<Cluster> clusters;
+        // bins store the exact sum of their values, only the cluster boundaries are quantized
+        std::vector<size_t> counts(n_bins, 0);
+        std::vector<double> sums(n_bins, 0);
 
-        struct HueElement
+        for (size_t y = 0; y < height; ++y)
         {
-            size_t n;
-            float saturation_sum;
-            float value_sum;
-        };
+            for (size_t x = 0; x < width; ++x)
+            {
+                const float value = std::clamp(image._data(x, y).x(), 0.f, 1.f);
+                const size_t bin = detail::to_k_means_gray_bin(value);
+                counts[bin] += 1;
+                sums[bin] += value;
+            }
+        }
 
-        // heuristic to pick initial cluster centers
-        std::vector<HueElement> hue_histogram;
-        std::vector<size_t> gray_histogram;
+        // prefix sums make the mean of any range of bins O(1)
+        std::vector<size_t> count_prefix(n_bins + 1, 0);
+        std::vector<double> sum_prefix(n_bins + 1, 0);
+        std::vector<size_t> occupied;
 
-        for (size_t i = 0; i < 256; ++i)
+        for (size_t bin = 0; bin < n_bins; ++bin)
         {
-            hue_histogram.emplace_back(HueElement{0, 0});
-            gray_histogram.emplace_back(0);
+            count_prefix[bin + 1] = count_prefix[bin] + counts[bin];
+            sum_prefix[bin + 1] = sum_prefix[bin] + sums[bin];
+
+            if (counts[bin] > 0)
+                occupied.push_back(bin);
         }
 
-        for (long x = 0; x < image.get_size().x(); ++x)
-        for (long y = 0; y < image.get_size().y(); ++y)
-        {
-            auto hsv = image(x, y).to_hsv();
+        GrayScaleImage out;
+        out.create(width, height);
 
-            if (hsv.saturation() < 0.33)
-                gray_histogram.at(int(hsv.value() * 255)) += 1;
-            else
-            {
-                auto& element = hue_histogram.at(int(hsv.hue() * 255));
-                element.n += 1;
-                element.saturation_sum += hsv.saturation();
-                element.value_sum += hsv.value();
-            }
-        }
+        if (occupied.empty() or n_clusters == 0)
+            return out;
 
-        // try to find centrum in hue band
-        int interval = int(255 / (n_clusters));
-        std::vector<size_t> gray_clusters;
+        n_clusters = std::min(n_clusters, occupied.size());
+        const size_t n_pixels = count_prefix.back();
+
+        // initialize centers at the quantiles of the histogram, each in a distinct occupied bin so centers are strictly increasing
+        std::vector<double> centers(n_clusters);
+        size_t previous = 0;
 
         for (size_t i = 0; i < n_clusters; ++i)
         {
-            int max_hue = i * interval;
-            size_t max_hue_n = 0;
-            float s_sum = 0;
-            float n_sum = 0;
-            float v_sum = 0;
+            const size_t quantile = (2 * i + 1) * n_pixels / (2 * n_clusters);
+            size_t position = std::upper_bound(occupied.begin(), occupied.end(), quantile, [&](size_t value, size_t bin){
+                return value < count_prefix[bin + 1];
+            }) - occupied.begin();
 
-            for (size_t hue = i * interval; hue < hue_histogram.size() and hue < (i+1) * interval; ++hue)
-            {
-                if (hue_histogram.at(hue).n > max_hue_n)
-                {
-                    max_hue = hue;
-                    max_hue_n = hue_histogram.at(hue).n;
-                }
+            if (i > 0)
+                position = std::max(position, previous + 1);
 
-                s_sum += hue_histogram.at(hue).saturation_sum;
-                v_sum += hue_histogram.at(hue).value_sum;
-                n_sum += hue_histogram.at(hue).n;
-            }
+            position = std::min(position, occupied.size() - (n_clusters - i));
+            previous = position;
 
-            if (n_sum == 0 or s_sum / n_sum < 0.33 or v_sum / n_sum < 0.25)
-                gray_clusters.push_back(i);
-            else
-            {
-                auto hsv = HSV{max_hue / 255.f, s_sum / n_sum, v_sum / n_sum};
-                auto color = hsv.to_rgb();
-                clusters.emplace_back(Cluster{color, 1, color});
-            }
+            const size_t bin = occupied[position];
+            centers[i] = sums[bin] / counts[bin];
         }
 
-        if (gray_clusters.size() > 0)
+        // in 1d each cluster is a contiguous range of bins, delimited by the midpoints between neighboring centers
+        std::vector<size_t> boundaries(n_clusters + 1, 0);
+        boundaries.back() = n_bins;
+
+        for (size_t n_iterations = 0; ; ++n_iterations)
         {
-            interval = int(255 / gray_clusters.size());
-            for (size_t i = 0; i < gray_clusters.size(); ++i)
+            bool changed = false;
+            for (size_t i = 1; i < n_clusters; ++i)
             {
-                int max_gray = 0;
-                size_t max_gray_n = 0;
+                // first bin whose value lies past the midpoint
+                const double midpoint = 0.5 * (centers[i - 1] + centers[i]);
+                const size_t boundary = std::clamp<double>(std::floor(midpoint * (n_bins - 1)) + 1, 0, n_bins);
 
-                for (size_t gray = i * interval; gray < gray_histogram.size() and gray < (i + 1) * interval; ++gray)
+                if (boundary != boundaries[i])
                 {
-                    if (gray_histogram.at(gray) > max_gray_n)
-                    {
-                        max_gray = gray;
-                        max_gray_n = gray_histogram.at(gray);
-                    }
+                    boundaries[i] = boundary;
+                    changed = true;
                 }
+            }
 
-                auto color = RGB(max_gray / 255.f, max_gray / 255.f, max_gray / 255.f);
-                clusters.emplace_back(Cluster{color, 1, color});
+            if (not changed or n_iterations >= max_n_iterations)
+                break;
+
+            // empty clusters keep their center, it still lies between its neighbors so the order is preserved
+            for (size_t i = 0; i < n_clusters; ++i)
+            {
+                const size_t n = count_prefix[boundaries[i + 1]] - count_prefix[boundaries[i]];
+                if (n > 0)
+                    centers[i] = (sum_prefix[boundaries[i + 1]] - sum_prefix[boundaries[i]]) / n;
             }
         }
 
-        auto dist = [](RGB a, RGB b) -> int
-        {
-            auto a_hsv = a.to_hsv(), b_hsv = b.to_hsv();
+        std::vector<float> lut(n_bins);
+        for (size_t i = 0; i < n_clusters; ++i)
+            std::fill(lut.begin() + boundaries[i], lut.begin() + boundaries[i + 1], centers[i]);
 
-            int score = abs(int(a.red() * 255) - int(b.red() * 255)) +
-                        abs(int(a.green() * 255) - int(b.green() * 255)) +
-                        abs(int(a.blue() * 255) - int(b.blue() * 255));
+        ThreadPool::get().parallel_for_ranges(height, [&](size_t y_begin, size_t y_end){
+            for (size_t y = y_begin; y < y_end; ++y)
+                for (size_t x = 0; x < width; ++x)
+                    out._data(x, y).x() = lut[detail::to_k_means_gray_bin(image._data(x, y).x())];
+        }, 64);
 
-            return score;
-        };
+        return out;
+    }
+
+    template<>
+    inline ColorImage k_means_clustering<ColorImage>(const ColorImage& image, size_t n_clusters, size_t max_n_iterations)
+    {
+        constexpr size_t n_bins = size_t(1) << (3 * detail::k_means_n_color_bits);
 
-        ColorImage out; // .r is cluster index
-        out.create(image.get_size().x(), image.get_size().y(), RGB(-1, 0, 0));
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y();
 
-        size_t n_changed = 1;
-        size_t n_iterations = 0;
-        while (n_changed != 0 and n_iterations < max_n_iterations)
+        // quantized color histogram, each cell stores the exact sum of its colors
+        std::vector<size_t> counts(n_bins, 0);
+        std::vector<std::array<double, 3>> sums(n_bins, {0, 0, 0});
+
+        for (size_t y = 0; y < height; ++y)
         {
-            n_changed = 0;
-            for (long x = 0; x < image.get_size().x(); ++x)
+            for (size_t x = 0; x < width; ++x)
             {
-                for (long y = 0; y < image.get_size().y(); ++y)
-                {
-                    int min_distance = std::numeric_limits<int>::max();
-                    size_t min_cluster_i = -1;
+                const auto& color = image._data(x, y);
+                const size_t bin = detail::to_k_means_color_bin(color);
+                counts[bin] += 1;
+                sums[bin][0] += color.red();
+                sums[bin][1] += color.green();
+                sums[bin][2] += color.blue();
+            }
+        }
 
-                    for (size_t i = 0; i < clusters.size(); ++i)
-                    {
-                        auto current_distance = dist(image(x, y), clusters.at(i).mean_color);
-                        if (current_distance < min_distance)
-                        {
-                            min_distance = current_distance;
-                            min_cluster_i = i;
-                        }
-                    }
+        // occupied cells, represented by the mean of their colors, form a weighted coreset of the image
+        std::vector<size_t> bins, weights;
+        std::vector<detail::KMeansPoint> colors;
 
-                    int old_i = int(out(x, y).x());
+        for (size_t bin = 0; bin < n_bins; ++bin)
+        {
+            if (counts[bin] == 0)
+                continue;
 
-                    if (old_i < 0 or old_i >= clusters.size())
-                    {
-                        out(x, y) = RGB(min_cluster_i);
-                        clusters.at(min_cluster_i).n += 1;
-                        clusters.at(min_cluster_i).color_sum += image(x, y);
+            bins.push_back(bin);
+            weights.push_back(counts[bin]);
+            colors.push_back({float(sums[bin][0] / counts[bin]), float(sums[bin][1] / counts[bin]), float(sums[bin][2] / counts[bin])});
+        }
 
-                        if (n_iterations > 0)
-                        {
-                            clusters.at(min_cluster_i).mean_color = clusters.at(min_cluster_i).color_sum;
-                            clusters.at(min_cluster_i).mean_color /= clusters.at(min_cluster_i).n;
-                        }
+        ColorImage out;
+        out.create(width, height);
 
-                        n_changed++;
-                    }
-                    else if (out(x, y).x() != min_cluster_i)
-                    {
-                        auto before_dist = dist(clusters.at(old_i).mean_color, clusters.at(min_cluster_i).mean_color);
+        if (colors.empty() or n_clusters == 0)
+            return out;
 
-                        clusters.at(old_i).n -= 1;
-                        clusters.at(old_i).color_sum -= image(x, y);
+        std::mt19937 engine(detail::k_means_seed);
+        auto centers = detail::k_means_plus_plus(colors, weights, n_clusters, engine);
+        const auto assignment = detail::hamerly_k_means(colors, weights, centers, max_n_iterations);
 
-                        if (n_iterations >= 0)
-                        {
-                            clusters.at(old_i).mean_color = clusters.at(old_i).color_sum;
-                            clusters.at(old_i).mean_color /= clusters.at(old_i).n;
-                        }
+        std::vector<uint32_t> lut(n_bins, 0);
+        for (size_t i = 0; i < colors.size(); ++i)
+            lut[bins[i]] = assignment[i];
 
-                        out(x, y) = RGB(min_cluster_i);
+        ThreadPool::get().parallel_for_ranges(height, [&](size_t y_begin, size_t y_end){
+            for (size_t y = y_begin; y < y_end; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const auto& center = centers[lut[detail::to_k_means_color_bin(image._data(x, y))]];
+                    out._data(x, y) = RGB(center[0], center[1], center[2]);
+                }
+            }
+        }, 64);
 
-                        clusters.at(min_cluster_i).n += 1;
-                        clusters.at(min_cluster_i).color_sum += image(x, y);
+        return out;
+    }
 
-                        if (n_iterations >= 0)
-                        {
-                            clusters.at(min_cluster_i).mean_color = clusters.at(min_cluster_i).color_sum;
-                            clusters.at(min_cluster_i).mean_color /= clusters.at(min_cluster_i).n;
-                        }
+    inline ColorImage mini_batch_k_means_clustering(const ColorImage& image, size_t n_clusters, size_t batch_size, size_t n_iterations)
+    {
+        const size_t width = image.get_size().x(),
+                     height = image.get_size().y(),
+                     n_pixels = width * height;
 
-                        auto after_dist = dist(clusters.at(old_i).mean_color, clusters.at(min_cluster_i).mean_color);
+        ColorImage out;
+        out.create(width, height);
 
-                        if (abs(after_dist - before_dist) > 0)
-                            n_changed++;
-                    }
-                }
-            }
+        if (n_pixels == 0 or n_clusters == 0 or batch_size == 0)
+            return out;
+
+        std::mt19937 engine(detail::k_means_seed);
+        std::uniform_int_distribution<size_t> distribution(0, n_pixels - 1);
 
-            if (n_iterations == 0)
+        std::vector<detail::KMeansPoint> batch(batch_size);
+        auto sample = [&]()
+        {
+            for (auto& point : batch)
             {
-                for (auto& cluster : clusters)
-                {
-                    cluster.mean_color = cluster.color_sum;
-                    cluster.mean_color /= cluster.n;
-                }
+                const size_t i = distribution(engine);
+                const auto& color = image._data(i % width, i / width);
+                point = {color.red(), color.green(), color.blue()};
             }
+        };
 
-            n_iterations++;
-        }
+        sample();
+        auto centers = detail::k_means_plus_plus(batch, std::vector<size_t>(batch_size, 1), n_clusters, engine);
+
+        // each center moves towards its assigned samples with a per-center learning rate of 1 / number of samples seen so far
+        std::vector<size_t> n_seen(centers.size(), 0);
+        std::vector<uint32_t> assignment(batch_size);
+        const size_t n_chunks = (batch_size + detail::k_means_chunk_size - 1) / detail::k_means_chunk_size;
 
-        for (size_t i = 0; i < clusters.size(); ++i)
+        for (size_t iteration = 0; iteration < n_iterations; ++iteration)
         {
-            for (size_t j = 0; j < clusters.size(); ++j)
-            {
-                if (i == j)
-                    continue;
+            sample();
 
-                // pseudo merge
-                if (dist(clusters.at(i).mean_color, clusters.at(j).mean_color) < 1)
+            ThreadPool::get().parallel_for(n_chunks, [&](size_t chunk){
+                for (size_t i = chunk * detail::k_means_chunk_size; i < std::min(batch_size, (chunk + 1) * detail::k_means_chunk_size); ++i)
                 {
-                    size_t new_n = clusters.at(i).n + clusters.at(j).n;
-                    RGB new_sum = clusters.at(i).color_sum;
-                    new_sum += clusters.at(j).color_sum;
+                    float closest_distance, second_distance;
+                    detail::find_two_closest_centers(batch[i], centers, assignment[i], closest_distance, second_distance);
+                }
+            });
 
-                    clusters.at(i).color_sum = new_sum;
-                    clusters.at(i).n = new_n;
-                    clusters.at(i).mean_color = new_sum;
-                    clusters.at(i).mean_color /= clusters.at(i).n;
+            for (size_t i = 0; i < batch_size; ++i)
+            {
+                auto& center = centers[assignment[i]];
+                const float rate = 1.f / ++n_seen[assignment[i]];
 
-                    clusters.at(j).color_sum = new_sum;
-                    clusters.at(j).n = new_n;
-                    clusters.at(j).mean_color = new_sum;
-                    clusters.at(j).mean_color /= clusters.at(j).n;
-                }
+                for (size_t j = 0; j < 3; ++j)
+                    center[j] += rate * (batch[i][j] - center[j]);
             }
         }
 
-        for (auto& px : out)
-        {
-            px = clusters.at(px.x()).mean_color;
-        }
+        const auto lut = detail::compute_color_bin_lut(centers);
+
+        ThreadPool::get().parallel_for_ranges(height, [&](size_t y_begin, size_t y_end){
+            for (size_t y = y_begin; y < y_end; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const auto& center = centers[lut[detail::to_k_means_color_bin(image._data(x, y))]];
+                    out._data(x, y) = RGB(center[0], center[1], center[2]);
+                }
+            }
+        }, 64);
 
         return out;
     }
-}
\ No newline at end of file
+}
@@ -49,10 +49,13 @@ namespace crisp
         _min_spectrum = std::numeric_limits<float>::max();
         _max_spectrum = std::numeric_limits<float>::min();
 
-        auto* complex = fftwf_alloc_complex(in.size());
+        // cached plans require fftw-aligned arrays
+        auto* real = fftwf_alloc_real(in.size());
+        auto* complex = fftwf_alloc_complex(in.size() / 2 + 1);
+        std::copy(in.begin(), in.end(), real);
 
-        auto plan = fftwf_plan_dft_r2c_1d(in.size(), &in[0], complex, FFTW_ESTIMATE);
-        fftwf_execute(plan);
+        auto plan = FourierPlanCache::get().get_dft_r2c_1d<float>(in.size());
+        fftwf_execute_dft_r2c(plan.get(), real, complex);
 
         in.resize(_data.rows());
         for (size_t i = 0; i < in.size(); ++i)
@@ -64,7 +67,7 @@ namespace crisp
             _max_spectrum = std::max<float>(_max_spectrum, in.at(i));
         }
 
-        fftwf_destroy_plan(plan);
+        fftwf_free(real);
         fftwf_free(complex);
 
         auto low_boost = [](auto x){ return x;};//x * exp(-0.5*pow((3*x), 4));};
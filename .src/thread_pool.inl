@@ -0,0 +1,179 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#include <memory>
+
+namespace crisp
+{
+    inline ThreadPool& ThreadPool::get()
+    {
+        static ThreadPool pool = ThreadPool(std::max<size_t>(std::thread::hardware_concurrency(), 1) - 1);
+        return pool;
+    }
+
+    inline ThreadPool::ThreadPool(size_t n_workers)
+    {
+        start(n_workers);
+    }
+
+    inline ThreadPool::~ThreadPool()
+    {
+        stop();
+    }
+
+    inline void ThreadPool::start(size_t n_workers)
+    {
+        _shutdown = false;
+        for (size_t i = 0; i < n_workers; ++i)
+            _workers.emplace_back([this](){ worker_loop(); });
+    }
+
+    inline void ThreadPool::stop()
+    {
+        {
+            auto lock = std::lock_guard(_queue_mutex);
+            _shutdown = true;
+        }
+
+        _queue_cv.notify_all();
+        for (auto& worker : _workers)
+            worker.join();
+
+        _workers.clear();
+    }
+
+    inline size_t ThreadPool::get_n_threads() const
+    {
+        return _workers.size() + 1;
+    }
+
+    inline void ThreadPool::set_n_threads(size_t n)
+    {
+        stop();
+        start(std::max<size_t>(n, 1) - 1);
+    }
+
+    inline void ThreadPool::submit(std::function<void()> task)
+    {
+        {
+            auto lock = std::lock_guard(_queue_mutex);
+            _queue.push_back(std::move(task));
+        }
+
+        _queue_cv.notify_one();
+    }
+
+    inline void ThreadPool::worker_loop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+
+            {
+                auto lock = std::unique_lock(_queue_mutex);
+                _queue_cv.wait(lock, [&](){ return _shutdown or not _queue.empty(); });
+
+                if (_queue.empty())
+                    return;
+
+                task = std::move(_queue.front());
+                _queue.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    template<typename Function_t>
+    void ThreadPool::parallel_for(size_t n, Function_t&& function)
+    {
+        if (n == 0)
+            return;
+
+        if (n == 1 or _workers.empty())
+        {
+            for (size_t i = 0; i < n; ++i)
+                function(i);
+
+            return;
+        }
+
+        // helpers that are dequeued after all indices were handed out return immediately,
+        // the batch is shared so it outlives the call while the function itself is never touched again
+        struct Batch
+        {
+            std::atomic<size_t> next = 0;
+            std::atomic<size_t> n_done = 0;
+            std::mutex mutex;
+            std::condition_variable cv;
+        };
+
+        auto batch = std::make_shared<Batch>();
+        auto* function_ptr = &function;
+
+        auto work = [batch, function_ptr, n]()
+        {
+            size_t i;
+            while ((i = batch->next.fetch_add(1)) < n)
+            {
+                (*function_ptr)(i);
+
+                if (batch->n_done.fetch_add(1) + 1 == n)
+                {
+                    auto lock = std::lock_guard(batch->mutex);
+                    batch->cv.notify_all();
+                }
+            }
+        };
+
+        for (size_t i = 0; i < std::min(n - 1, _workers.size()); ++i)
+            submit(work);
+
+        work();
+
+        auto lock = std::unique_lock(batch->mutex);
+        batch->cv.wait(lock, [&](){ return batch->n_done.load() == n; });
+    }
+
+    template<typename Function_t>
+    void ThreadPool::parallel_for_ranges(size_t n, Function_t&& function, size_t min_range_size)
+    {
+        if (n == 0)
+            return;
+
+        // a few ranges per thread so uneven ranges are balanced out
+        size_t n_ranges = std::min(get_n_threads() * 4, (n + min_range_size - 1) / std::max<size_t>(min_range_size, 1));
+        n_ranges = std::max<size_t>(n_ranges, 1);
+
+        size_t range_size = (n + n_ranges - 1) / n_ranges;
+        n_ranges = (n + range_size - 1) / range_size;
+
+        parallel_for(n_ranges, [&](size_t i)
+        {
+            function(i * range_size, std::min(n, (i + 1) * range_size));
+        });
+    }
+
+    template<typename Function_t>
+    void ThreadPool::parallel_for_tiles(size_t width, size_t height, Function_t&& function, size_t tile_width, size_t tile_height)
+    {
+        if (width == 0 or height == 0)
+            return;
+
+        tile_width = std::max<size_t>(std::min(tile_width, width), 1);
+        tile_height = std::max<size_t>(std::min(tile_height, height), 1);
+
+        const size_t n_x = (width + tile_width - 1) / tile_width,
+                     n_y = (height + tile_height - 1) / tile_height;
+
+        parallel_for(n_x * n_y, [&](size_t i)
+        {
+            size_t x = i % n_x,
+                   y = i / n_x;
+
+            function(x * tile_width, std::min(width, (x + 1) * tile_width), y * tile_height, std::min(height, (y + 1) * tile_height));
+        });
+    }
+}
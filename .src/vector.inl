@@ -105,7 +105,7 @@ namespace crisp
     Vector <T, N> Vector<T, N>::operator-(const Vector <T, N>& other) const noexcept
     {
         auto out = *this;
-        out *= other;
+        out -= other;
         return out;
     }
 
@@ -0,0 +1,94 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#pragma once
+
+#include <vector.hpp>
+#include <image_region.hpp>
+#include <fourier_plan_cache.hpp>
+
+#include <vector>
+
+#include <fftw3.h>
+#include <Dense>
+
+namespace crisp
+{
+    /// @brief signature of a boundary that is fourier transformed to compute its descriptors
+    enum class ShapeSignature
+    {
+        /// @brief each point (x, y) is the complex number x + i*y
+        COMPLEX_COORDINATE,
+
+        /// @brief distance of each point to the centroid of all points
+        RADIAL_DISTANCE,
+
+        /// @brief distance of each point to the point farthest from it
+        FARTHEST_POINT
+    };
+
+    /// @brief computes translation, scale and rotation invariant fourier descriptors of many closed boundaries at once
+    class FourierDescriptorEngine
+    {
+        public:
+            /// @brief ctor, plans the batched transform, or reuses the plan cached by crisp::FourierPlanCache
+            /// @param n_samples: number of points each boundary is resampled to, a power of 2 is fastest (default: 64)
+            /// @param n_descriptors: number of descriptors per boundary, at most n_samples - 2 for ShapeSignature::COMPLEX_COORDINATE and n_samples / 2 otherwise (default: 16)
+            /// @param signature: signature that is transformed (default: ShapeSignature::COMPLEX_COORDINATE)
+            FourierDescriptorEngine(size_t n_samples = 64, size_t n_descriptors = 16, ShapeSignature signature = ShapeSignature::COMPLEX_COORDINATE);
+
+            /// @brief compute descriptors of boundaries given as ordered points
+            /// @param boundaries: vector of boundaries, each the ordered points of a closed curve, as returned by ImageRegion::get_boundary
+            /// @returns matrix of size n_descriptors x n_boundaries, column i holding the descriptors of boundary i
+            /// @complexity O(n_boundaries * (m + n_samples * log(n_samples))) where m the number of points per boundary, O(n_boundaries * n_samples^2) for ShapeSignature::FARTHEST_POINT
+            Eigen::MatrixXf compute(const std::vector<std::vector<Vector2ui>>& boundaries) const;
+
+            /// @brief compute descriptors of contours
+            /// @param contours: vector of contours, as returned by crisp::trace_contours
+            /// @returns matrix of size n_descriptors x n_contours, column i holding the descriptors of contour i
+            Eigen::MatrixXf compute(const std::vector<Contour>& contours) const;
+
+            /// @brief compute descriptors of the outer boundary of regions
+            /// @param regions: vector of regions
+            /// @returns matrix of size n_descriptors x n_regions, column i holding the descriptors of region i
+            template<typename Image_t>
+            Eigen::MatrixXf compute(const std::vector<ImageRegion<Image_t>>& regions) const;
+
+            /// @brief get number of points each boundary is resampled to
+            /// @returns number of samples
+            size_t get_n_samples() const;
+
+            /// @brief get number of descriptors per boundary
+            /// @returns number of rows of the feature matrix
+            size_t get_n_descriptors() const;
+
+            /// @brief get signature that is transformed
+            /// @returns signature
+            ShapeSignature get_signature() const;
+
+        private:
+            // boundary i is accessed through get_points(i), which returns the ordered points of a closed curve
+            template<typename Function_t>
+            Eigen::MatrixXf compute_from(size_t n_boundaries, Function_t&& get_points) const;
+
+            // write the signature of the resampled boundary into the transform input
+            void fill_signature(const std::vector<Vector2ui>& points, fftwf_complex* out) const;
+
+            // write the normalized descriptors from the spectrum
+            void fill_descriptors(const fftwf_complex* spectrum, float* out) const;
+
+            // number of boundaries transformed by one execution of the plan
+            static constexpr size_t _batch_size = 256;
+
+            size_t _n_samples;
+            size_t _n_descriptors;
+            ShapeSignature _signature;
+
+            // shared with crisp::FourierPlanCache, keeps the plan alive if the cache is cleared
+            detail::FFTWPlan<float> _plan;
+    };
+}
+
+#include ".src/fourier_descriptors.inl"
@@ -0,0 +1,153 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#pragma once
+
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include <fftw3.h>
+
+namespace crisp
+{
+    /// @brief how much time fftw spends on finding the fastest way to compute a transform of a given size
+    enum class PlanningRigor : unsigned
+    {
+        /// @brief heuristic, planning is instant but the transform may be far from optimal
+        ESTIMATE = FFTW_ESTIMATE,
+
+        /// @brief measure a few candidates, planning may take seconds for large sizes
+        MEASURE = FFTW_MEASURE,
+
+        /// @brief measure a wide range of candidates, planning may take minutes for large sizes
+        PATIENT = FFTW_PATIENT,
+
+        /// @brief measure all candidates, only worth it if the plans are persisted as wisdom
+        EXHAUSTIVE = FFTW_EXHAUSTIVE
+    };
+
+    namespace detail
+    {
+        // precision-specific fftw functions, specialized for float (fftw3f), double (fftw3) and long double (fftw3l)
+        template<typename Value_t>
+        struct FFTW;
+
+        // shared ownership of a plan, the plan is destroyed once neither the cache nor any user holds it
+        template<typename Value_t>
+        using FFTWPlan = std::shared_ptr<std::remove_pointer_t<typename FFTW<Value_t>::Plan_t>>;
+    }
+
+    /// @brief process-wide cache of fftw plans, so each transform size is only planned once
+    /// @note plans are handed out as shared pointers, keep the pointer alive for as long as the plan is executed
+    /// @note plans are created for arrays allocated with fftw_alloc_complex and fftw_alloc_real or their float and long double versions, and should be executed with fftw_execute_dft, fftw_execute_dft_r2c and fftw_execute_dft_c2r or their float and long double versions
+    class FourierPlanCache
+    {
+        public:
+            /// @brief access the global cache, created on first use, which imports the wisdom stored at get_wisdom_file
+            /// @returns reference to cache
+            static FourierPlanCache& get();
+
+            /// @brief dtor, exports wisdom if new plans were created, then destroys all plans
+            ~FourierPlanCache();
+
+            /// @brief set planning rigor for plans created from now on, already cached plans are kept
+            /// @param rigor: rigor, default: PlanningRigor::MEASURE
+            void set_planning_rigor(PlanningRigor);
+
+            /// @brief get planning rigor
+            /// @returns rigor
+            PlanningRigor get_planning_rigor() const;
+
+            /// @brief set file wisdom is persisted to and import the wisdom stored there
+            /// @param path: path prefix, wisdom of each precision is stored in its own file: path.fftw3f, path.fftw3 and path.fftw3l
+            /// @returns true if wisdom of at least one precision was imported, false otherwise
+            bool set_wisdom_file(const std::string& path);
+
+            /// @brief get file wisdom is persisted to
+            /// @returns path prefix, default: resource path + ".fftw_wisdom"
+            std::string get_wisdom_file() const;
+
+            /// @brief export the wisdom of all precisions to the wisdom file
+            /// @returns true if all files could be written, false otherwise
+            bool export_wisdom() const;
+
+            /// @brief release all cached plans, wisdom is kept so replanning a size is fast
+            /// @note plans still held by a transform are only destroyed once it releases them
+            void clear();
+
+            /// @brief get plan of an in-place complex 2d transform
+            /// @param m: number of rows
+            /// @param n: number of columns
+            /// @param direction: FFTW_FORWARD or FFTW_BACKWARD
+            /// @returns plan, shared with the cache
+            template<typename Value_t>
+            detail::FFTWPlan<Value_t> get_dft_2d(size_t m, size_t n, int direction);
+
+            /// @brief get plan of many in-place complex 1d transforms of contiguous signals
+            /// @param n: number of samples per signal
+            /// @param n_signals: number of signals transformed by one execution
+            /// @param direction: FFTW_FORWARD or FFTW_BACKWARD
+            /// @returns plan, shared with the cache
+            template<typename Value_t>
+            detail::FFTWPlan<Value_t> get_dft_1d_batch(size_t n, size_t n_signals, int direction);
+
+            /// @brief get plan of an out-of-place real-to-complex 1d transform, computing only the n / 2 + 1 non-redundant coefficients
+            /// @param n: number of samples
+            /// @returns plan, shared with the cache
+            template<typename Value_t>
+            detail::FFTWPlan<Value_t> get_dft_r2c_1d(size_t n);
+
+            /// @brief get plan of an out-of-place real-to-complex 2d transform, computing only the m * (n / 2 + 1) non-redundant coefficients
+            /// @param m: number of rows
+            /// @param n: number of columns
+            /// @returns plan, shared with the cache
+            template<typename Value_t>
+            detail::FFTWPlan<Value_t> get_dft_r2c_2d(size_t m, size_t n);
+
+            /// @brief get plan of an out-of-place complex-to-real 2d transform, the inverse of get_dft_r2c_2d
+            /// @param m: number of rows
+            /// @param n: number of columns
+            /// @returns plan, shared with the cache
+            /// @note executing the plan overwrites the complex input
+            template<typename Value_t>
+            detail::FFTWPlan<Value_t> get_dft_c2r_2d(size_t m, size_t n);
+
+        private:
+            FourierPlanCache();
+
+            // precision, transform type, direction, size along each dimension, planning flags
+            using Key_t = std::tuple<int, int, int, size_t, size_t, unsigned>;
+
+            enum TransformType : int
+            {
+                DFT_2D,
+                DFT_1D_BATCH,
+                DFT_REAL_1D,
+                DFT_REAL_2D
+            };
+
+            template<typename Value_t, typename Plan_Function_t>
+            detail::FFTWPlan<Value_t> get_plan(Key_t, Plan_Function_t&&);
+
+            // guards the cache itself
+            mutable std::mutex _mutex;
+
+            // the fftw planner is not thread-safe, so this guards every call into it: planning, destroying plans and wisdom
+            // shared with the deleters of all plans, so a plan can still be released after the cache is gone
+            std::shared_ptr<std::mutex> _planner_mutex = std::make_shared<std::mutex>();
+
+            std::map<Key_t, std::shared_ptr<void>> _plans;
+
+            PlanningRigor _rigor = PlanningRigor::MEASURE;
+            std::string _wisdom_file;
+            bool _wisdom_changed = false;
+    };
+}
+
+#include ".src/fourier_plan_cache.inl"
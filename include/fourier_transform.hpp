@@ -9,6 +9,7 @@
 #include <image/multi_plane_image.hpp>
 #include <image/grayscale_image.hpp>
 #include <gpu_side/texture.hpp>
+#include <fourier_plan_cache.hpp>
 
 #include <complex>
 #include <vector>
@@ -108,11 +109,11 @@ namespace crisp
             Vector2ui get_size() const;
 
             /// @brief expose spectrum
-            /// @returns reference to spectrum as vector
+            /// @returns reference to spectrum as vector, coefficient (x, y) is at index x + y * get_size().x()
             std::vector<Value_t>& get_spectrum();
 
             /// @brief expose phase angle
-            /// @returns reference to phase angle as vector
+            /// @returns reference to phase angle as vector, coefficient (x, y) is at index x + y * get_size().x()
             std::vector<Value_t>& get_phase_angle();
 
         private:
@@ -128,6 +129,92 @@ namespace crisp
     template<FourierTransformMode Mode>
     using FourierTransform2D = FourierTransform<Mode>;
 
+    /// @brief fourier transform of a real image that only computes and stores the non-redundant half of the spectrum, values stored as magnitude and phase-angle
+    /// @param mode: any of SPEED, BALANCED, ACCURACY, governs runtime performance
+    /// @note the spectrum of a real image is conjugate-symmetric, the coefficient at (x, y) is the complex conjugate of the coefficient at (m - x, n - y), so only columns y in [0, n/2] are stored
+    /// @note get_component(x, y) refers to the same frequency as FourierTransform::get_component(x, y), only the layout of get_spectrum differs
+    template<FourierTransformMode Mode = BALANCED>
+    class RealFourierTransform
+    {
+        template<typename>
+        friend class FrequencyDomainFilter;
+
+        using Value_t = typename std::conditional<Mode == SPEED, float, typename std::conditional<Mode == ACCURACY, long double, double>::type>::type;
+
+        public:
+            /// @brief default ctor
+            RealFourierTransform() = default;
+
+            /// @brief creates fourier transform from an image
+            /// @param image: image the transform is constructed from
+            template<typename Inner_t>
+            void transform_from(const Image<Inner_t, 1>&);
+
+            /// @brief transform back into an image, this does not modify the transform
+            /// @returns resulting image
+            template<typename Image_t>
+            Image_t transform_to() const;
+
+            /// @brief visualizes the full spectrum as an image
+            /// @returns log(1+x)-scaled grayscale image of size m*n*2 where m, n size of the original transformed image
+            [[nodiscard]] GrayScaleImage as_image() const;
+
+            /// @brief get the complex coefficient at the specified position, (0,0) being the top-left origin
+            /// @param x: the row index, range [0, 2*m]
+            /// @param y: the column index, range [0, 2*n]
+            /// @returns coefficient as std::complex, reconstructed from its conjugate if not stored
+            std::complex<Value_t> get_coefficient(size_t x, size_t y) const;
+
+            /// @brief const-access the component of the spectrum at the specified position, (0,0) being the top-left origin
+            /// @param x: the row index, range [0, 2*m]
+            /// @param y: the column index, range [0, 2*n]
+            /// @returns coefficients magnitude, float if in SPEED mode, double otherwise
+            Value_t get_component(size_t x, size_t y) const;
+
+            /// @brief access the component of the spectrum at the specified position, (0,0) being the top-left origin
+            /// @param x: the row index, range [0, 2*m]
+            /// @param y: the column index, range [0, 2*n]
+            /// @returns reference to coefficients magnitude, which is shared with its conjugate at (m - x, n - y)
+            Value_t& get_component(size_t x, size_t y);
+
+            /// @brief const-access the phase angle at the specified position, (0,0) being the top-left origin
+            /// @param x: the row index, range [0, 2*m]
+            /// @param y: the column index, range [0, 2*n]
+            /// @returns angle in radians, float if in SPEED mode, double otherwise
+            Value_t get_phase_angle(size_t x, size_t y) const;
+
+            /// @brief access the dc-component (the value at the spectrums center)
+            /// @returns float if in SPEED mode, double otherwise
+            /// @note equivalent to calling get_component(m/2, n/2) where m,n size of the transform
+            Value_t get_dc_component() const;
+
+            /// @brief get the size of the full spectrum
+            /// @returns vector where .x is the width, .y the height of the transform
+            Vector2ui get_size() const;
+
+            /// @brief get the size of the stored half of the spectrum
+            /// @returns vector where .x is the width, .y / 2 + 1 the height of the transform
+            Vector2ui get_stored_size() const;
+
+            /// @brief expose stored half of the spectrum
+            /// @returns reference to spectrum as vector, coefficient (x, y) is at index x * get_stored_size().y() + y
+            std::vector<Value_t>& get_spectrum();
+
+            /// @brief expose stored half of the phase angles
+            /// @returns reference to phase angles as vector, coefficient (x, y) is at index x * get_stored_size().y() + y
+            std::vector<Value_t>& get_phase_angle();
+
+        private:
+            // index of the stored coefficient and whether (x, y) is its conjugate
+            std::pair<size_t, bool> to_index(size_t x, size_t y) const;
+
+            Vector2ui _size;
+            std::vector<Value_t> _spectrum,
+                                 _phase_angle;
+
+            Value_t _min_spectrum = 0, _max_spectrum = 1; // already log(1+x) scaled
+    };
+
     template<FourierTransformMode Mode>
     class FourierTransform1D
     {
@@ -212,4 +299,5 @@ namespace crisp
 }
 
 #include ".src/fourier_transform_2d.inl"
+#include ".src/real_fourier_transform.inl"
 #include ".src/fourier_transform_1d.inl"
\ No newline at end of file
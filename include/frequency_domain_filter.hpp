@@ -35,6 +35,18 @@ namespace crisp
             template<FourierTransformMode Mode>
             void apply_to(FourierTransform<Mode>&) const;
 
+            /// @brief construct filter of the same size as the full spectrum
+            /// @param spectrum
+            template<FourierTransformMode Mode>
+            FrequencyDomainFilter(const RealFourierTransform<Mode>&);
+
+            /// @brief multiply the filter with the stored half of a fourier spectrum
+            /// @tparam mode: performance mode of transform, usually auto deduced
+            /// @param spectrum: the spectrum to be modified
+            /// @note each stored coefficient also stands in for its conjugate at (m - x, n - y), so the filter should be symmetric around the center of the spectrum. All filter shapes are, unless an offset is set without forcing symmetry
+            template<FourierTransformMode Mode>
+            void apply_to(RealFourierTransform<Mode>&) const;
+
             /// @brief resize the filter
             /// @param size: vector where .x is the x-dimensions and .y the y-dimensions of the spectrum the filter will be applied to
             void set_size(Vector2ui);
@@ -8,6 +8,7 @@
 #include <image/multi_plane_image.hpp>
 
 #include <unordered_map>
+#include <vector>
 
 namespace crisp
 {
@@ -32,6 +33,11 @@ namespace crisp
             template<typename Range_t>
             void create_from(const Range_t&);
 
+            /// @brief create from already accumulated bin counts, for example if the values were recorded as part of another pass
+            /// @param counts: vector of N_Bins + 1 elements, where the element at index i is the number of elements in bin i
+            /// @param mean: mean of all recorded values
+            void create_from_counts(std::vector<size_t> counts, double mean);
+
             /// @brief access number of elements
             /// @param bin_index: index in [0, N_Bins]
             size_t at(size_t bin_index) const;
@@ -40,6 +46,15 @@ namespace crisp
             /// @param intensity: intensity in [0, 1]
             size_t get_n_occurrences(float intensity) const;
 
+            /// @brief access number of elements of all bins as one contiguous array
+            /// @returns const reference to vector of N_Bins + 1 elements, where the element at index i is the number of elements in bin i
+            const std::vector<size_t>& get_counts() const;
+
+            /// @brief get index of the bin an intensity is sorted into
+            /// @param intensity: intensity, clamped into [0, 1]
+            /// @returns index in [0, N_Bins]
+            static size_t to_bin_index(float intensity);
+
             /// @brief access sum of occurrences over all intensities
             /// @returns size_t
             size_t get_n_total() const;
@@ -71,6 +86,7 @@ namespace crisp
         private:
             double _mean;
             size_t _n_sum;
+            std::vector<size_t> _counts;
             std::unordered_map<size_t, size_t> _data;
     };
 }
@@ -59,6 +59,12 @@ namespace crisp
             /// @returns const reference to value, if the index is out of bounds, modifying the reference has no effect on the image
             virtual Value_t& operator()(int x, int y);
 
+            /// @brief access pixel or padding if out of range, does not modify the image so it may be called concurrently
+            /// @param x: row index
+            /// @param y: column index
+            /// @returns copy of value
+            Value_t get_pixel_or_padding(int x, int y) const;
+
             /// @brief access pixel with bounds checking
             /// @param x: row index
             /// @param y: column index
@@ -6,8 +6,14 @@
 #pragma once
 
 #include <image/multi_plane_image.hpp>
+#include <image_segment.hpp>
+#include <histogram.hpp>
+#include <thread_pool.hpp>
+#include <polygon.hpp>
 
 #include <set>
+#include <array>
+#include <optional>
 
 namespace crisp 
 {
@@ -32,14 +38,184 @@ namespace crisp
         MINUS_45
     };
 
+    /// @brief closed contour of a labeled area, stored as its first pixel and a chain code
+    struct Contour
+    {
+        /// @brief label of the pixels the contour runs along
+        uint32_t label = 0;
+
+        /// @brief false if the contour separates the area from its surroundings, true if it separates the area from a hole inside it
+        bool is_hole = false;
+
+        /// @brief first pixel of the contour, the top-most, left-most pixel for outer contours
+        Vector2ui start = Vector2ui{0, 0};
+
+        /// @brief direction from each pixel to the next, where 0 is west, 1 is south-west, 2 is south, ..., 7 is north-west. The last code leads back to start, a contour of a single pixel has no codes
+        std::vector<uint8_t> chain_code;
+
+        /// @brief get number of pixels of the contour
+        /// @returns number of pixels, pixels on parts of the area that are only one pixel wide are counted once per visit
+        size_t size() const;
+
+        /// @brief reconstruct all pixels of the contour
+        /// @returns vector of pixel coordinates, starting at start. Outer contours are enumerated counter-clockwise, hole contours clockwise
+        std::vector<Vector2ui> to_points() const;
+    };
+
+    /// @brief trace the outer contour and the contours of all holes of every labeled area in one raster scan, using Suzuki-Abe border following
+    /// @param labels: label image, for example as returned by crisp::Segmentation::label_connected_components
+    /// @param background: if specified, no contours are traced for pixels with this label (default: 0)
+    /// @returns contours in order of their first pixel, left-to-right, top-to-bottom
+    /// @complexity O(m*n)
+    /// @note Suzuki, S., & Abe, K. (1985). Topological structural analysis of digitized binary images by border following. Computer Vision, Graphics, and Image Processing, 30(1), 32–46
+    std::vector<Contour> trace_contours(const Image<uint32_t, 1>& labels, std::optional<uint32_t> background = 0);
+
+    /// @brief co-occurrence matrix of quantized intensities, only pairs of levels that occur at least once are stored
+    struct CoOccurrenceMatrix
+    {
+        /// @brief non-zero element of the matrix
+        struct Entry
+        {
+            /// @brief quantized intensity of the first pixel of the pair
+            uint16_t row;
+
+            /// @brief quantized intensity of the second pixel of the pair
+            uint16_t col;
+
+            /// @brief number of occurrences of the pair divided by the total number of pairs
+            float probability;
+        };
+
+        /// @brief number of quantization levels, the matrix is of size n_levels x n_levels
+        size_t n_levels = 0;
+
+        /// @brief total number of pixel pairs observed
+        size_t n_pairs = 0;
+
+        /// @brief all non-zero elements, ordered by row, then column
+        std::vector<Entry> entries;
+
+        /// @brief access element
+        /// @param row: quantized intensity of the first pixel
+        /// @param col: quantized intensity of the second pixel
+        /// @returns probability of the pair, 0 if it does not occur
+        /// @complexity O(log n_entries)
+        float at(size_t row, size_t col) const;
+
+        /// @brief convert to a dense matrix
+        /// @returns n_levels x n_levels matrix
+        Eigen::MatrixXf as_dense() const;
+    };
+
+    /// @brief Haralick texture features, computed from one co-occurrence matrix. Logarithms are natural logarithms
+    /// @note Haralick, R. M., Shanmugam, K., & Dinstein, I. (1973). Textural Features for Image Classification. IEEE Transactions on Systems, Man, and Cybernetics, SMC-3(6), 610–621
+    struct HaralickFeatures
+    {
+        /// @brief f1, sum of squared probabilities, also called energy or uniformity
+        float angular_second_moment = 0;
+
+        /// @brief f2, mean squared difference of the levels of a pair
+        float contrast = 0;
+
+        /// @brief f3, linear dependency of the levels of a pair, in [-1, 1]. 0 if either marginal distribution has zero variance
+        float correlation = 0;
+
+        /// @brief f4, variance of the first level of a pair
+        float sum_of_squares_variance = 0;
+
+        /// @brief f5, also called homogeneity
+        float inverse_difference_moment = 0;
+
+        /// @brief f6, mean of the sum of the levels of a pair
+        float sum_average = 0;
+
+        /// @brief f7, variance of the sum of the levels of a pair
+        float sum_variance = 0;
+
+        /// @brief f8, entropy of the sum of the levels of a pair
+        float sum_entropy = 0;
+
+        /// @brief f9, entropy of the matrix
+        float entropy = 0;
+
+        /// @brief f10, variance of the absolute difference of the levels of a pair
+        float difference_variance = 0;
+
+        /// @brief f11, entropy of the absolute difference of the levels of a pair
+        float difference_entropy = 0;
+
+        /// @brief f12, first information measure of correlation, in [-1, 0]
+        float information_measure_of_correlation_1 = 0;
+
+        /// @brief f13, second information measure of correlation, in [0, 1]
+        float information_measure_of_correlation_2 = 0;
+    };
+
+    /// @brief statistical descriptors of the intensities of a region, all computed in one pass over the region
+    struct RegionStatistics
+    {
+        /// @brief number of elements
+        size_t n = 0;
+
+        /// @brief mean intensity
+        float mean = 0;
+
+        /// @brief population variance of intensities
+        float variance = 0;
+
+        /// @brief 3rd standardized moment, 0 if the variance is 0
+        float skewness = 0;
+
+        /// @brief 4th standardized moment, 0 if the variance is 0
+        float kurtosis = 0;
+
+        /// @brief raw moments E[x^k] for k in {0, 1, 2, 3, 4}
+        std::array<float, 5> raw_moments = {0, 0, 0, 0, 0};
+
+        /// @brief central moments E[(x - mean)^k] for k in {0, 1, 2, 3, 4}
+        std::array<float, 5> central_moments = {0, 0, 0, 0, 0};
+
+        /// @brief smallest intensity
+        float min = 0;
+
+        /// @brief largest intensity
+        float max = 0;
+
+        /// @brief probability of the most common quantized intensity
+        float max_probability = 0;
+
+        /// @brief entropy of the quantized intensities, normalized into [0, 1]
+        float average_entropy = 0;
+
+        /// @brief histogram of intensities quantized into [0, 256]
+        Histogram<256> histogram;
+    };
+
+    /// @brief geometric moments of the shape of a region, every pixel has weight 1 regardless of its intensity
+    struct ShapeMoments
+    {
+        /// @brief raw moments m_pq = sum of x^p * y^q over all pixels, indexed [p][q], only defined for p + q <= 3, 0 otherwise
+        std::array<std::array<double, 4>, 4> raw = {};
+
+        /// @brief central moments mu_pq around the centroid, indexed [p][q], only defined for p + q <= 3, 0 otherwise
+        std::array<std::array<double, 4>, 4> central = {};
+
+        /// @brief scale invariant moments eta_pq = mu_pq / m_00^((p + q) / 2 + 1), indexed [p][q], only defined for p + q <= 3, 0 otherwise
+        std::array<std::array<double, 4>, 4> normalized = {};
+
+        /// @brief mean pixel coordinate (m_10 / m_00, m_01 / m_00)
+        Vector2f centroid = Vector2f{0, 0};
+
+        /// @brief the seven Hu moment invariants of the shape
+        std::array<float, 7> hu_moments = {0, 0, 0, 0, 0, 0, 0};
+    };
+
     /// @brief a region is a an image segment along with the corresponding image values
     template<typename Image_t>
     class ImageRegion
     {   
         using Value_t = typename Image_t::Value_t;
-        class Iterator;
-        class ConstIterator;
-            
+
         public:
             /// @brief default ctor
             ImageRegion() = default;
@@ -53,6 +229,16 @@ namespace crisp
             /// @param segment: set of pixel coordinates
             /// @param image
             void create_from(const ImageSegment& segment, const Image_t& image);
+
+            /// @brief construct from run-length encoded segment and image
+            /// @param segment: runs of pixel coordinates
+            /// @param image
+            ImageRegion(const RunLengthSegment& segment, const Image_t& image);
+
+            /// @brief construct from run-length encoded segment and image
+            /// @param segment: runs of pixel coordinates
+            /// @param image
+            void create_from(const RunLengthSegment& segment, const Image_t& image);
             
             /// @brief construct region from entire image
             /// @param image:
@@ -74,6 +260,32 @@ namespace crisp
             /// @returns const reference to stored vector of positions
             const std::vector<Vector2ui>& get_boundary_polygon() const;
 
+            /// @brief get boundary polygon with all vertices removed that contribute little to its shape
+            /// @param tolerance: distance in pixels for PolygonSimplification::DOUGLAS_PEUCKER, area in pixels for PolygonSimplification::VISVALINGAM_WHYATT
+            /// @param algorithm: algorithm used (default: PolygonSimplification::DOUGLAS_PEUCKER)
+            /// @returns subset of the boundary polygon vertices, in counter-clockwise order
+            std::vector<Vector2ui> get_simplified_boundary_polygon(float tolerance, PolygonSimplification algorithm = PolygonSimplification::DOUGLAS_PEUCKER) const;
+
+            /// @brief get convex hull of the region, including all of its parts if it is not connected
+            /// @returns vertices of the hull, a subset of the regions pixels, in counter-clockwise order
+            /// @complexity O(n log n) where n the number of rows of the region
+            std::vector<Vector2ui> get_convex_hull() const;
+
+            /// @brief get solidity: area / area of the convex hull
+            /// @returns solidity in (0, 1], close to 1 for convex regions, lower along diagonal edges because of pixelation
+            /// @note the hull is taken around the pixels outer corners so the hull of a single pixel has area 1
+            float get_solidity() const;
+
+            /// @brief get parts of the boundary that deviate inwards from its convex hull
+            /// @note only the boundary polygon is considered, which for regions that are not connected only encloses the part containing the first pixel
+            /// @param min_depth: defects not deeper than this many pixels are discarded, shallow defects are caused by the boundary being pixelated (default: 1)
+            /// @returns defects, indices refer to get_boundary_polygon
+            std::vector<ConvexityDefect> get_convexity_defects(float min_depth = 1) const;
+
+            /// @brief get the rectangle of smallest area containing all pixels of the region, including all of its parts if it is not connected
+            /// @returns rectangle, its corners are pixel centers
+            RotatedRectangle get_minimum_area_rectangle() const;
+
             /// @brief compute farthest point signature as proposed by El-ghazal, Basir, Belkasim (2009) in counter-clockwise order
             /// @returns vector of distances
             /// @notes El-ghazal, A., Basir, O., & Belkasim, S. (2009). Farthest point distance: A new shape signature for Fourier descriptors. Signal Processing: Image Communication, 24(7), 572–586. doi:10.1016/j.image.2009.04.00
@@ -128,20 +340,33 @@ namespace crisp
             size_t get_n_holes() const;
 
             /// @brief get boundaries for holes
-            /// @returns vector of vectors where each of them is the closed boundary of a hole, enumerated in counter-clockwise direction
+            /// @returns vector of vectors where each of them is the closed boundary of a hole, enumerated in clockwise direction
+            /// @note the boundaries are reconstructed from their chain codes on first access
             const std::vector<std::vector<Vector2ui>>& get_hole_boundaries() const;
             
-            /// @brief get the nths Hu moment invariant
+            /// @brief get the nths Hu moment invariant, where each pixel is weighted by its intensity
             /// @param n: n in {1, 2, ..., 6, 7}
             /// @returns value of invariant
+            /// @note all 7 invariants are computed in one pass over all elements and cached
             float get_nths_moment_invariant(size_t n);
+
+            /// @brief get geometric moments up to order 3 and the Hu moment invariants of the region's shape, computed from the left and right end of each horizontal run of pixels using the discrete version of Green's theorem
+            /// @returns const reference to moments
+            /// @complexity O(n_runs), where the number of runs is bounded by the number of boundary pixels
+            const ShapeMoments& get_shape_moments() const;
             
+            /// @brief get all intensity statistics, computed in one pass over all elements and cached
+            /// @returns const reference to statistics
+            /// @note get_mean, get_variance, get_skewness, get_kurtosis, get_average_entropy, get_maximum_intensity_probability and get_intensity_histogram all share this cache
+            const RegionStatistics& get_statistics() const;
+
             /// @brief get maximum probability of intensity value
             /// @returns float in [0, 1]
             float get_maximum_intensity_probability() const;
 
             /// @brief get pearsons nths normalized moment around the mean of texture
             /// @returns value
+            /// @note moments for n > 4 need an additional pass over all elements
             float get_nths_moment(size_t n) const;
 
             /// @brief get mean of texture
@@ -171,8 +396,28 @@ namespace crisp
             /// @brief get co-occurrence matrix (the number of occurrences of a pair of intensities) in specified direction. For images with multiple planes, intensities are the average intensity per element
             /// @param direction
             /// @returns 256x256 matrix, all elements normalized to [0, 1]
+            /// @note equivalent to get_co_occurrence(direction, 256).as_dense()
             const auto& get_co_occurrence_matrix(CoOccurrenceDirection direction) const;
 
+            /// @brief get sparse co-occurrence matrix of intensities quantized into n_levels levels in specified direction
+            /// @param direction
+            /// @param n_levels: number of quantization levels, in [2, 256] (default: 32)
+            /// @returns const reference to matrix
+            /// @note matrices for all 8 directions are computed in one pass over the region and cached, per number of levels
+            const CoOccurrenceMatrix& get_co_occurrence(CoOccurrenceDirection direction, size_t n_levels = 32) const;
+
+            /// @brief compute Haralick texture features from the co-occurrence matrix in specified direction
+            /// @param direction
+            /// @param n_levels: number of quantization levels, in [2, 256] (default: 32)
+            /// @returns features
+            /// @complexity O(n_entries + n_levels)
+            HaralickFeatures get_haralick_features(CoOccurrenceDirection direction, size_t n_levels = 32) const;
+
+            /// @brief compute Haralick texture features averaged over all 8 directions, which makes them invariant to rotation by multiples of 45°
+            /// @param n_levels: number of quantization levels, in [2, 256] (default: 32)
+            /// @returns features
+            HaralickFeatures get_mean_haralick_features(size_t n_levels = 32) const;
+
             /// @brief get measure of correlation of the intensity values
             /// @returns float in [-1, 1]
             float get_intensity_correlation(CoOccurrenceDirection) const;
@@ -189,12 +434,30 @@ namespace crisp
             /// @returns float in [0, 1]
             float get_contrast(CoOccurrenceDirection) const;
 
-            /// @brief get const iterator to first element
+            /// @brief check if pixel is part of the region
+            /// @param position: pixel coordinate in the original image
+            /// @returns true if contained, false otherwise
+            /// @complexity O(1)
+            bool contains(Vector2ui) const;
+
+            /// @brief get pixel coordinates of all elements
+            /// @returns const reference to positions, ordered left-to-right, top-to-bottom
+            const std::vector<Vector2ui>& get_positions() const;
+
+            /// @brief get values of all elements
+            /// @returns const reference to values, in the same order as get_positions()
+            const std::vector<Value_t>& get_values() const;
+
+            /// @brief get intensities of all elements, the mean over all planes of each value
+            /// @returns const reference to intensities, in the same order as get_positions()
+            const std::vector<float>& get_intensities() const;
+
+            /// @brief get const iterator to first pixel coordinate
             /// @returns const iterator
             /// @note no non-const iterator is supplied
             auto begin() const;
 
-            /// @brief get const iterator to past-the-end element
+            /// @brief get const iterator to past-the-end pixel coordinate
             /// @returns const iterator
             /// @note no non-const iterator is supplied
             auto end() const;
@@ -202,31 +465,33 @@ namespace crisp
         private:
             void create();
 
-            struct Element
-            {
-                Element(Vector2ui, Value_t);
+            // append element, elements have to be added in scan order
+            void push_back_element(Vector2ui, const Value_t&);
 
-                Vector2ui _position;
-                Value_t _value;
-                float _intensity;
-            };
-            
-            struct ElementCompare
-            {
-                // sorts left-to-right, top to bottom
-                bool operator()(const Element& a, const Element& b) const
-                {
-                    return a.position.x() != b.position.x() ? a.position.x() < b.position.x() : a.position.y() < b.position.y();
-                }
-            };
+            // leftmost and rightmost pixel of each row, their convex hull is that of the entire region
+            std::vector<Vector2ui> get_row_extremes() const;
+
+            // index of the element at (x, y) or -1 if the pixel is not part of the region
+            size_t get_element_index(size_t x, size_t y) const;
 
             static constexpr inline size_t QUANTIZATION_N = 256;
-            
-            std::map<size_t, Element> _elements;
-            
+
+            // elements in scan order, left-to-right, top-to-bottom, stored as one array per attribute
+            std::vector<Vector2ui> _positions;
+            std::vector<Value_t> _values;
+            std::vector<float> _intensities;
+
+            // element index + 1 of each pixel of the bounding box, 0 for pixels not part of the region
+            std::vector<uint32_t> _element_indices;
+
+            // horizontal runs of consecutive elements, in scan order
+            std::vector<RunLengthSegment::Run> _runs;
+
             std::vector<Vector2ui> _boundary;
             std::vector<Vector2ui> _boundary_polygon;
-            std::vector<std::vector<Vector2ui>> _hole_boundaries;
+            std::vector<Contour> _hole_contours;
+            mutable std::vector<std::vector<Vector2ui>> _hole_boundaries;
+            mutable bool _hole_boundaries_initialized = false;
 
             size_t _min_x, _max_x, _mean_x;
             size_t _min_y, _max_y, _mean_y;
@@ -239,21 +504,76 @@ namespace crisp
 
             Vector2ui _original_image_size;
 
-            mutable bool _histogram_initialized = false;
-            mutable Histogram<QUANTIZATION_N> _histogram;
-
-            mutable float _intensity_mean = -1;
-            mutable float _intensity_variance = -1;
+            mutable bool _moment_invariants_initialized = false;
+            mutable std::array<float, 7> _moment_invariants;
 
-            mutable float _average_entropy = -1;
-            mutable float _max_probability = -1;
+            mutable bool _shape_moments_initialized = false;
+            mutable ShapeMoments _shape_moments;
 
-            mutable bool _intensity_occurrences_initialized = false;
-            mutable std::map<float, size_t> _intensity_occurrences;
+            mutable bool _statistics_initialized = false;
+            mutable RegionStatistics _statistics;
 
             mutable std::map<size_t, float> _nths_statistical_moment;
             mutable std::map<CoOccurrenceDirection, Eigen::MatrixXf> _co_occurrence_matrix;
+            mutable std::map<size_t, std::array<CoOccurrenceMatrix, 8>> _co_occurrences;
+    };
+
+    /// @brief shape and intensity descriptors of one labeled region of an image
+    struct RegionProperties
+    {
+        /// @brief number of features when converted to a feature vector, see crisp::to_feature_matrix
+        static constexpr size_t n_features = 18;
+
+        /// @brief label of the region
+        uint32_t label = 0;
+
+        /// @brief number of pixels
+        size_t area = 0;
+
+        /// @brief mean pixel coordinate
+        Vector2f centroid = Vector2f{0, 0};
+
+        /// @brief top-left corner of the bounding box
+        Vector2ui min = Vector2ui{0, 0};
+
+        /// @brief bottom-right corner of the bounding box, inclusive
+        Vector2ui max = Vector2ui{0, 0};
+
+        /// @brief angle between the x-axis and the major axis of the ellipse with the same second moments as the region, in radians, in [-pi/2, pi/2]. Since y points down, positive angles are clockwise
+        float orientation = 0;
+
+        /// @brief length of the major axis of the ellipse with the same second moments as the region
+        float major_axis_length = 0;
+
+        /// @brief length of the minor axis of the ellipse with the same second moments as the region
+        float minor_axis_length = 0;
+
+        /// @brief eccentricity of the ellipse with the same second moments as the region, 0 for a circle, approaching 1 for a line
+        float eccentricity = 0;
+
+        /// @brief mean intensity, where the intensity of a pixel is the mean over all its planes
+        float mean = 0;
+
+        /// @brief population variance of intensities
+        float variance = 0;
+
+        /// @brief the seven Hu moment invariants of the regions shape
+        std::array<float, 7> hu_moments = {0, 0, 0, 0, 0, 0, 0};
     };
+
+    /// @brief compute shape and intensity descriptors of all labeled regions of an image at once
+    /// @param labels: label image, for example as returned by crisp::Segmentation::label_connected_components
+    /// @param image: image the intensities are read from, has to be the same size as labels
+    /// @returns vector where the element at index i holds the properties of label i, including label 0. Labels without pixels have area 0
+    /// @complexity O(m*n + n_labels), two parallel sweeps over the image
+    template<typename Image_t>
+    std::vector<RegionProperties> compute_region_properties(const Image<uint32_t, 1>& labels, const Image_t& image);
+
+    /// @brief arrange region properties as a feature matrix, for example for crisp::BayesClassifier
+    /// @param properties: properties as returned by crisp::compute_region_properties
+    /// @param first_label: regions with a smaller label are skipped (default: 1, skips the background)
+    /// @returns matrix with one column per non-empty region, in order of labels. The rows are: area, centroid x, centroid y, bounding box width, bounding box height, orientation, major axis length, minor axis length, eccentricity, mean, variance and the 7 Hu moment invariants
+    Eigen::Matrix<float, RegionProperties::n_features, Eigen::Dynamic> to_feature_matrix(const std::vector<RegionProperties>& properties, uint32_t first_label = 1);
 }
 
 #include ".src/image_region.inl"
\ No newline at end of file
@@ -8,6 +8,8 @@
 #include <vector.hpp>
 
 #include <set>
+#include <vector>
+#include <iterator>
 
 namespace crisp
 {
@@ -29,4 +31,150 @@ namespace crisp
 
     /// @brief a set of unique pixel coordinates
     using ImageSegment = std::set<Vector2ui, detail::PixelCoordCompare>;
-}
\ No newline at end of file
+
+    /// @brief a set of unique pixel coordinates, stored as horizontal runs of consecutive pixels
+    /// @note iterates in the same order as crisp::ImageSegment, left-to-right, top-to-bottom
+    class RunLengthSegment
+    {
+        class ConstIterator;
+
+        public:
+            /// @brief horizontal run of pixels (x_begin, y) to (x_end - 1, y)
+            struct Run
+            {
+                /// @brief row index
+                size_t y;
+
+                /// @brief x-coordinate of the first pixel
+                size_t x_begin;
+
+                /// @brief x-coordinate past the last pixel
+                size_t x_end;
+
+                /// @brief equality operator
+                /// @param other: run
+                /// @returns true if all members are equal
+                bool operator==(const Run&) const;
+            };
+
+            /// @brief default ctor, empty segment
+            RunLengthSegment() = default;
+
+            /// @brief construct from pixel set
+            /// @param segment
+            explicit RunLengthSegment(const ImageSegment&);
+
+            /// @brief convert to pixel set, allows a run-length segment to be used wherever crisp::ImageSegment is expected
+            /// @returns new set of all pixels
+            operator ImageSegment() const;
+
+            /// @brief add a pixel
+            /// @param pixel: coordinate
+            void insert(Vector2ui);
+
+            /// @brief add all pixels of a run, merging it with touching or overlapping runs
+            /// @param y: row index
+            /// @param x_begin: x-coordinate of first pixel
+            /// @param x_end: x-coordinate past the last pixel
+            /// @complexity amortized O(1) if runs are added left-to-right, top-to-bottom, O(n_runs) otherwise
+            void insert_run(size_t y, size_t x_begin, size_t x_end);
+
+            /// @brief remove all pixels
+            void clear();
+
+            /// @brief check if pixel is part of the segment
+            /// @param pixel: coordinate
+            /// @returns true if contained, false otherwise
+            /// @complexity O(log n_runs)
+            bool contains(Vector2ui) const;
+
+            /// @brief get number of pixels
+            /// @returns area in pixels
+            size_t size() const;
+
+            /// @brief check if segment has no pixels
+            /// @returns true if size() == 0
+            bool empty() const;
+
+            /// @brief get number of runs
+            /// @returns number of runs
+            size_t get_n_runs() const;
+
+            /// @brief access the runs
+            /// @returns const reference to runs, ordered top-to-bottom and left-to-right, no two runs touch or overlap
+            const std::vector<Run>& get_runs() const;
+
+            /// @brief get axis aligned bounding box
+            /// @returns pair of top-left and bottom-right corner, inclusive
+            std::pair<Vector2ui, Vector2ui> get_bounding_box() const;
+
+            /// @brief set union
+            /// @param other: segment
+            /// @returns segment with all pixels that are in either segment
+            /// @complexity O(n_runs + other.n_runs)
+            RunLengthSegment operator|(const RunLengthSegment&) const;
+
+            /// @brief set intersection
+            /// @param other: segment
+            /// @returns segment with all pixels that are in both segments
+            /// @complexity O(n_runs + other.n_runs)
+            RunLengthSegment operator&(const RunLengthSegment&) const;
+
+            /// @brief set difference
+            /// @param other: segment
+            /// @returns segment with all pixels that are in this segment but not in other
+            /// @complexity O(n_runs + other.n_runs)
+            RunLengthSegment operator-(const RunLengthSegment&) const;
+
+            /// @brief equality operator
+            /// @param other: segment
+            /// @returns true if both segments contain the same pixels
+            bool operator==(const RunLengthSegment&) const;
+
+            /// @brief inequality operator
+            /// @param other: segment
+            /// @returns false if both segments contain the same pixels
+            bool operator!=(const RunLengthSegment&) const;
+
+            /// @brief const begin
+            /// @returns iterator to first pixel
+            ConstIterator begin() const;
+
+            /// @brief const end
+            /// @returns iterator to past-the-end pixel
+            ConstIterator end() const;
+
+        private:
+            // append run, merges with the last run if they touch. Runs have to be appended in order
+            void push_back_run(size_t y, size_t x_begin, size_t x_end);
+
+            std::vector<Run> _runs;
+            size_t _n_pixels = 0;
+
+            class ConstIterator
+            {
+                public:
+                    ConstIterator(const std::vector<Run>*, size_t run_i, size_t x);
+
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = Vector2ui;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const Vector2ui*;
+                    using reference = Vector2ui;
+
+                    bool operator==(const ConstIterator& other) const;
+                    bool operator!=(const ConstIterator& other) const;
+
+                    ConstIterator& operator++();
+                    ConstIterator operator++(int);
+
+                    Vector2ui operator*() const;
+
+                private:
+                    const std::vector<Run>* _runs;
+                    size_t _run_i, _x;
+            };
+    };
+}
+
+#include ".src/image_segment.inl"
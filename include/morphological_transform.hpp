@@ -9,12 +9,26 @@
 #include <vector.hpp>
 #include <gpu_side/texture.hpp>
 #include <structuring_element.hpp>
+#include <thread_pool.hpp>
+
+#include <vector>
 
 namespace crisp
 {
     template<typename, size_t>
     class Texture;
 
+    /// @brief result of MorphologicalTransform::granulometry
+    template<typename Image_t>
+    struct Granulometry
+    {
+        /// @brief element i is the volume (sum of all pixel values) removed between the opening at scale i and scale i+1, where scale 0 is the image itself
+        std::vector<double> pattern_spectrum;
+
+        /// @brief element i is the white top-hat (image minus its opening) at scale i+1, empty unless requested
+        std::vector<Image_t> top_hats;
+    };
+
     /// @brief object representing a morphological transform using a flat structuring element
     class MorphologicalTransform
     {
@@ -28,6 +42,7 @@ namespace crisp
 
             /// @brief expose the structuring element
             /// @returns reference to current structuring element
+            /// @note the structuring element is recompiled on the next transform, references should not be kept across transforms
             StructuringElement& get_structuring_element();
 
             /// @brief access component of structuring element
@@ -115,6 +130,15 @@ namespace crisp
             template<typename T, size_t N>
             void close(Texture<T, N>& texture);
 
+            /// @brief open an image with structuring elements of increasing size and record the volume removed at each scale
+            /// @param image: image to be analyzed, will not be modified
+            /// @param n_scales: number of scales, scale n opens with n copies of the current structuring element combined by dilation
+            /// @param compute_top_hats: should the top-hat image of each scale be returned (default: false)
+            /// @returns pattern spectrum and, if requested, top-hat images
+            /// @note for square(3) scale n is identical to opening with square(2n + 1), for diamond(3) to opening with diamond(2n + 1)
+            template<typename Image_t>
+            Granulometry<Image_t> granulometry(const Image_t& image, size_t n_scales, bool compute_top_hats = false);
+
             /// @brief set all pixels where the structuring element occurs in the image to 1, zero otherwise
             /// @param image: image to be modified
             template<typename Image_t>
@@ -188,11 +212,26 @@ namespace crisp
             Vector2ui _origin;
             StructuringElement _structuring_element;
 
+            // structuring element compiled into offsets relative to the origin, "don't care" elements removed
+            // sorted column-major to match the image storage order, recompiled lazily after any modification
+            void compile_structuring_element();
+
+            bool _offsets_up_to_date = false;
+            std::vector<Vector2i> _foreground_offsets,
+                                  _background_offsets;
+
+            // tile size of the parallel cpu engine, tiles span full columns where possible since images are column-major
+            static constexpr size_t TILE_WIDTH = 4096,
+                                    TILE_HEIGHT = 32;
+
+            template<bool Erode, typename Image_t>
+            void erode_or_dilate_aux(const Image_t&, Image_t&);
+
             template<typename Image_t>
-            void erode_aux(Image_t&, Image_t&);
+            void erode_aux(const Image_t&, Image_t&);
 
             template<typename Image_t>
-            void dilate_aux(Image_t&, Image_t&);
+            void dilate_aux(const Image_t&, Image_t&);
     };
 }
 
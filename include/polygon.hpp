@@ -0,0 +1,100 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#pragma once
+
+#include <vector.hpp>
+
+#include <vector>
+#include <array>
+
+namespace crisp
+{
+    /// @brief algorithm used to remove vertices from a polygon
+    enum class PolygonSimplification
+    {
+        /// @brief keep the vertex farthest from the line connecting two kept vertices, until no vertex is farther than the tolerance. Tolerance is a distance in pixels
+        DOUGLAS_PEUCKER,
+
+        /// @brief remove the vertex forming the triangle of smallest area with its two neighbors, until no triangle is smaller than the tolerance. Tolerance is an area in pixels
+        VISVALINGAM_WHYATT
+    };
+
+    /// @brief remove vertices of a closed polygon that contribute little to its shape
+    /// @param polygon: vertices in order, the last vertex connects to the first
+    /// @param tolerance: distance or area, depending on the algorithm. Vertices not exceeding it are removed
+    /// @param algorithm: algorithm used (default: PolygonSimplification::DOUGLAS_PEUCKER)
+    /// @returns subset of vertices in the same order. Polygons with more than 3 vertices keep at least 2 for DOUGLAS_PEUCKER, which always keeps the first vertex, and at least 3 for VISVALINGAM_WHYATT
+    /// @complexity O(n log n) on average, O(n^2) worst case for DOUGLAS_PEUCKER, O(n log n) for VISVALINGAM_WHYATT
+    template<typename T>
+    std::vector<Vector<T, 2>> simplify_polygon(const std::vector<Vector<T, 2>>& polygon, float tolerance, PolygonSimplification algorithm = PolygonSimplification::DOUGLAS_PEUCKER);
+
+    /// @brief compute smallest convex polygon containing all points, using Andrew's monotone chain algorithm
+    /// @param points: points in any order
+    /// @returns vertices of the hull in counter-clockwise order, the same direction as ImageRegion::get_boundary. Vertices lying on an edge of the hull are not included
+    /// @complexity O(n log n)
+    template<typename T>
+    std::vector<Vector<T, 2>> convex_hull(const std::vector<Vector<T, 2>>& points);
+
+    /// @brief compute area enclosed by a closed polygon using the shoelace formula
+    /// @param polygon: vertices in order, the last vertex connects to the first
+    /// @returns area, always positive
+    template<typename T>
+    float polygon_area(const std::vector<Vector<T, 2>>& polygon);
+
+    /// @brief part of a polygon that deviates inwards from its convex hull
+    struct ConvexityDefect
+    {
+        /// @brief index of the hull vertex where the defect begins
+        size_t begin;
+
+        /// @brief index of the hull vertex where the defect ends
+        size_t end;
+
+        /// @brief index of the vertex in-between begin and end that is farthest from the hull
+        size_t deepest;
+
+        /// @brief distance of the deepest vertex to the hull edge from begin to end
+        float depth;
+    };
+
+    /// @brief find all parts of a closed polygon that deviate inwards from its convex hull
+    /// @param polygon: vertices in order, the last vertex connects to the first, the polygon should not intersect itself
+    /// @param min_depth: defects with a depth smaller than or equal to this are discarded (default: 0)
+    /// @returns defects in order of their beginning, all indices refer to the polygon
+    /// @complexity O(n log n)
+    template<typename T>
+    std::vector<ConvexityDefect> convexity_defects(const std::vector<Vector<T, 2>>& polygon, float min_depth = 0);
+
+    /// @brief rectangle that is not necessarily aligned with the x- and y-axis
+    struct RotatedRectangle
+    {
+        /// @brief center of the rectangle
+        Vector2f center = Vector2f{0, 0};
+
+        /// @brief length of the side along angle, length of the side perpendicular to it
+        Vector2f size = Vector2f{0, 0};
+
+        /// @brief angle between the x-axis and the first side, in radians
+        float angle = 0;
+
+        /// @brief get corners
+        /// @returns array of 4 corners, in order
+        std::array<Vector2f, 4> get_corners() const;
+
+        /// @brief get area
+        /// @returns size.x() * size.y()
+        float get_area() const;
+    };
+
+    /// @brief compute the rectangle of smallest area containing all points, using rotating calipers on their convex hull
+    /// @param points: points in any order
+    /// @returns rectangle, one of its sides is collinear with an edge of the convex hull
+    /// @complexity O(n log n), O(h) after the hull is computed, where h the number of hull vertices
+    template<typename T>
+    RotatedRectangle minimum_area_rectangle(const std::vector<Vector<T, 2>>& points);
+}
+
+#include ".src/polygon.inl"
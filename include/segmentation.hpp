@@ -8,24 +8,128 @@
 #include <image_segment.hpp>
 #include <image/multi_plane_image.hpp>
 #include <image/binary_image.hpp>
+#include <histogram.hpp>
 
 #include <vector>
+#include <optional>
 
 namespace crisp::Segmentation
 {
+    /// @brief neighborhood used to decide whether two pixels of identical value are connected
+    enum class Connectivity
+    {
+        /// @brief left, right, top and bottom neighbor
+        FOUR = 4,
+
+        /// @brief all 8 neighbors, including diagonals
+        EIGHT = 8
+    };
+
+    /// @brief image holding one 32-bit label per pixel
+    using LabelImage = Image<uint32_t, 1>;
+
+    /// @brief statistics of one connected component, accumulated during labeling
+    struct ComponentStatistics
+    {
+        /// @brief number of pixels with this label
+        size_t n_pixels = 0;
+
+        /// @brief top-left corner of the bounding box
+        Vector2ui min = Vector2ui{0, 0};
+
+        /// @brief bottom-right corner of the bounding box, inclusive
+        Vector2ui max = Vector2ui{0, 0};
+
+        /// @brief mean pixel coordinate
+        Vector2f centroid = Vector2f{0, 0};
+    };
+
+    /// @brief result of connected component labeling
+    struct ConnectedComponents
+    {
+        /// @brief label of each pixel, components are labeled 1, 2, ... in order of their first pixel left-to-right, top-to-bottom. Label 0 is reserved for the background
+        LabelImage labels;
+
+        /// @brief statistics of each label, index 0 holds the background
+        std::vector<ComponentStatistics> statistics;
+
+        /// @brief get number of components, not counting the background
+        /// @returns number of labels - 1
+        size_t get_n_components() const;
+
+        /// @brief construct segment of one component
+        /// @param label: label of the component, 0 for the background
+        /// @returns segment, only the components bounding box is visited
+        ImageSegment get_segment(uint32_t label) const;
+
+        /// @brief construct run-length encoded segment of one component
+        /// @param label: label of the component, 0 for the background
+        /// @returns segment, only the components bounding box is visited
+        RunLengthSegment get_run_length_segment(uint32_t label) const;
+    };
+
+    /// @brief label all connected areas of identical value using two-pass union-find labeling
+    /// @param image
+    /// @param connectivity: FOUR or EIGHT (default: FOUR)
+    /// @param background: if specified, pixels of this value are not part of any component and receive label 0 (default: none)
+    /// @returns label image and per-label statistics
+    /// @complexity O(m*n)
+    template<typename Image_t>
+    ConnectedComponents label_connected_components(const Image_t&, Connectivity connectivity = Connectivity::FOUR, std::optional<typename Image_t::Value_t> background = std::nullopt);
+
+    /// @brief partition of an image into classes of pixels with identical value
+    struct ValuePartition
+    {
+        /// @brief class of each pixel, classes are numbered 0, 1, ... in order of their first pixel left-to-right, top-to-bottom
+        LabelImage labels;
+
+        /// @brief pixels of class i are pixel_indices[offsets[i]] to pixel_indices[offsets[i+1] - 1], has n_classes + 1 elements
+        std::vector<size_t> offsets;
+
+        /// @brief linear pixel indices x + y * width, grouped by class, within a class ordered left-to-right, top-to-bottom
+        std::vector<size_t> pixel_indices;
+
+        /// @brief get number of classes
+        /// @returns number of pairwise different pixel values
+        size_t get_n_classes() const;
+
+        /// @brief get number of pixels in a class
+        /// @param class_i: index of the class
+        /// @returns number of pixels
+        size_t get_n_pixels(size_t class_i) const;
+
+        /// @brief construct segment of one class
+        /// @param class_i: index of the class
+        /// @returns segment
+        ImageSegment get_segment(size_t class_i) const;
+
+        /// @brief construct run-length encoded segment of one class
+        /// @param class_i: index of the class
+        /// @returns segment
+        RunLengthSegment get_run_length_segment(size_t class_i) const;
+    };
+
+    /// @brief partition image into classes of identical pixel value using one counting sort
+    /// @param image
+    /// @returns label image and pixel indices of each class
+    /// @complexity O(m*n), images with integer values of at most 16 bits per pixel use a lookup table instead of hashing
+    template<typename Image_t>
+    ValuePartition partition_by_value(const Image_t&);
+
     /// @brief extract all pixels of identical value results in number of segments equal to the number of pairwise different pixel values
     /// @param image
     /// @param min_segment_size: minimum size of segments, discard if size is equal or below minimum
-    /// @returns vector of resulting segments
+    /// @returns vector of resulting segments, ordered by their first pixel left-to-right, top-to-bottom
     template<typename Image_t>
     std::vector<ImageSegment> decompose_into_segments(const Image_t&, size_t min_segment_size = 2);
 
-    /// @brief extract all 4-connected segments of identical value
+    /// @brief extract all connected segments of identical value
     /// @param image
-    /// @param min_segment_size: minimum size of segments, discard if size is equal or below minimum
-    /// @returns vector of resulting segments
+    /// @param min_segment_size: minimum size of segments, discard if size is below minimum
+    /// @param connectivity: FOUR or EIGHT (default: FOUR)
+    /// @returns vector of resulting segments, ordered by their first pixel left-to-right, top-to-bottom
     template<typename Image_t>
-    std::vector<ImageSegment> decompose_into_connected_segments(const Image_t&, size_t min_segment_size = 2);
+    std::vector<ImageSegment> decompose_into_connected_segments(const Image_t&, size_t min_segment_size = 2, Connectivity connectivity = Connectivity::FOUR);
 
     /// @brief compute threshold as specified
     /// @param image
@@ -46,6 +150,28 @@ namespace crisp::Segmentation
     template<typename Inner_t>
     BinaryImage otsu_threshold(const Image<Inner_t>&);
 
+    /// @brief compute threshold that maximizes between-cluster variance of a precomputed histogram
+    /// @param histogram
+    /// @returns bin index k such that bins [0, k] form the lower class
+    /// @complexity O(N_Bins)
+    template<size_t N_Bins>
+    size_t compute_otsu_threshold(const Histogram<N_Bins>&);
+
+    /// @brief compute multiple thresholds that maximize between-cluster variance of a precomputed histogram
+    /// @param histogram
+    /// @param n_thresholds: number of thresholds, results in n_thresholds + 1 classes
+    /// @returns ascending bin indices, class i spans bins (thresholds[i-1], thresholds[i]], the last class spans all bins above the last threshold
+    /// @complexity O(n_thresholds * N_Bins * log(N_Bins))
+    template<size_t N_Bins>
+    std::vector<size_t> compute_multi_otsu_thresholds(const Histogram<N_Bins>&, size_t n_thresholds);
+
+    /// @brief separate image into multiple classes using multi-level otsu's method
+    /// @param image
+    /// @param n_thresholds: number of thresholds, results in n_thresholds + 1 classes (default: 2)
+    /// @returns label image where each pixel holds the index of its class, classes are ordered by ascending intensity
+    template<typename Inner_t>
+    LabelImage multi_otsu_threshold(const Image<Inner_t>&, size_t n_thresholds = 2);
+
     /// @brief compute local threshold by iterating through the image in a spiral pattern and remember only part of values visited so far
     /// @param image
     /// @param tail_length_factor: scales the number of remember elements, in [0, 1], (default: 0.05)
@@ -56,12 +182,40 @@ namespace crisp::Segmentation
 
     /// @brief compute local threshold by considering the pixels neighborhood
     /// @param image
-    /// @param neighborhood_size: range of pixels considered (default: 5)
-    /// @returns thresholded image as binary
-    /// @complexity O(m*n*neighborhood_size)
+    /// @param neighborhood_size: range of pixels considered, the window spans 7 * neighborhood_size pixels in each direction (default: 5)
+    /// @returns thresholded image as binary, true where a pixel is darker than the mean of its neighborhood
+    /// @complexity O(m*n)
     template<typename Inner_t>
     BinaryImage neighborhood_threshold(const Image<Inner_t>&, size_t neighborhood_size = 5);
 
+    /// @brief compute local threshold T = mean + k * standard_deviation of each pixels window, as proposed by Niblack
+    /// @param image
+    /// @param window_size: side length of the square window centered on each pixel, should be odd (default: 15)
+    /// @param k: weight of the standard deviation (default: -0.2)
+    /// @returns thresholded image as binary, true where a pixel is above its threshold
+    /// @complexity O(m*n) for any window size
+    template<typename Inner_t>
+    BinaryImage niblack_threshold(const Image<Inner_t>&, size_t window_size = 15, float k = -0.2);
+
+    /// @brief compute local threshold T = mean * (1 + k * (standard_deviation / r - 1)) of each pixels window, as proposed by Sauvola and Pietikäinen
+    /// @param image
+    /// @param window_size: side length of the square window centered on each pixel, should be odd (default: 15)
+    /// @param k: sensitivity, in [0.2, 0.5] (default: 0.34)
+    /// @param r: dynamic range of the standard deviation (default: 0.5)
+    /// @returns thresholded image as binary, true where a pixel is above its threshold
+    /// @complexity O(m*n) for any window size
+    template<typename Inner_t>
+    BinaryImage sauvola_threshold(const Image<Inner_t>&, size_t window_size = 15, float k = 0.34, float r = 0.5);
+
+    /// @brief compute local threshold T = mean * (1 - t) of each pixels window, as proposed by Bradley and Roth
+    /// @param image
+    /// @param window_size: side length of the square window centered on each pixel, should be odd (default: 15)
+    /// @param t: fraction below the local mean a pixel needs to be to be considered dark (default: 0.15)
+    /// @returns thresholded image as binary, true where a pixel is above its threshold
+    /// @complexity O(m*n) for any window size
+    template<typename Inner_t>
+    BinaryImage bradley_threshold(const Image<Inner_t>&, size_t window_size = 15, float t = 0.15);
+
     /// @brief compute variable threshold of a texture by computing the local mean using sample points around each pixel
     /// @param texture
     /// @param neighborhood_size: spreads the range of sample points, does not decrease performance
@@ -70,29 +224,100 @@ namespace crisp::Segmentation
     template<typename T, size_t N>
     Texture<T, N> threshold(const Texture<T, N>&, size_t neighborhood_size, size_t correction);
 
+    /// @brief partition image into compact superpixels using simple linear iterative clustering (SLIC)
+    /// @param image: input image
+    /// @param n_superpixels: approximate number of superpixels
+    /// @param compactness: weight of the spatial distance relative to the value distance, higher values result in more regular superpixels (default: 0.1)
+    /// @param max_n_iterations: number of iterations allowed if convergence is not achieved earlier (default: 10)
+    /// @returns label image, each superpixel is 4-connected and superpixels are labeled 0, 1, ... in order of their first pixel left-to-right, top-to-bottom
+    /// @note converges once fewer than 0.1% of pixels change their superpixel during an iteration
+    template<typename Image_t>
+    LabelImage compute_superpixels(const Image_t&, size_t n_superpixels, float compactness = 0.1, size_t max_n_iterations = 10);
+
+    /// @brief partition image using the graph-based segmentation proposed by Felzenszwalb and Huttenlocher
+    /// @param image: input image
+    /// @param k: scale parameter, larger values result in larger segments (default: 1)
+    /// @param min_size: segments smaller than this many pixels are merged with their most similar neighbor (default: 20)
+    /// @param connectivity: neighborhood used to build the graph (default: 8-connected)
+    /// @returns label image, each segment is connected and segments are labeled 0, 1, ... in order of their first pixel left-to-right, top-to-bottom
+    /// @note edge weights are the euclidean distance between pixel values, quantized to 65536 levels
+    /// @complexity O(m*n * α(m*n))
+    template<typename Image_t>
+    LabelImage felzenszwalb_segmentation(const Image_t&, float k = 1, size_t min_size = 20, Connectivity connectivity = Connectivity::EIGHT);
+
     /// @brief cluster image but create n superpixels and k-means clustering inside their boundaries
     /// @param image: input image
     /// @param n_superpixels
     /// @param max_n_iterations: number of iterations allowed if convergence is not achieved earlier
-    /// @returns clustered image of same value type as input image
+    /// @returns clustered image of same value type as input image, each pixel is assigned the mean value of its superpixel
     template<typename Image_t>
     Image_t superpixel_clustering(const Image_t&, size_t n_superpixels, size_t max_n_iterations = std::numeric_limits<size_t>::max());
 
+    /// @brief grow regions from seeds by repeatedly adding the unassigned pixel closest to the mean of a neighboring region, as proposed by Adams and Bischof
+    /// @param image: input image
+    /// @param seeds: label image, pixels with label != 0 are seeds of the region with that label
+    /// @param connectivity: neighborhood of each pixel (default: 4-connected)
+    /// @returns label image, each pixel holds the label of the region it was added to or 0 if no region reached it
+    /// @note distances are quantized to 4096 levels, pixels of equal distance are added in the order they were first reached
+    /// @complexity amortized O(m*n)
+    template<typename Image_t>
+    LabelImage seeded_region_growing(const Image_t&, const LabelImage& seeds, Connectivity connectivity = Connectivity::FOUR);
+
     /// @brief cluster image by region growing
     /// @param image: input image
-    /// @param seed_image: binary image with seeds
-    /// @returns clustered image of same value type as input image, unclustered values will be show up as black (grayscale) or magenta (color)
+    /// @param seed_image: binary image with seeds, 8-connected seed pixels form one seed
+    /// @returns clustered image of same value type as input image, each pixel is assigned the mean value of its region, unclustered values will be show up as black (grayscale) or magenta (color)
     template<typename Image_t>
     Image_t region_growing_clustering(const Image_t&, BinaryImage seed_image);
 
+    /// @brief marker-controlled watershed, floods the gradient magnitude of the image starting at the markers
+    /// @param image: input image, the gradient is computed by crisp::compute_gradient_magnitude
+    /// @param markers: label image, pixels with label != 0 are markers of the region with that label
+    /// @param connectivity: neighborhood of each pixel (default: 4-connected)
+    /// @returns label image, each pixel holds the label of the marker whose basin it belongs to or 0 if no marker reached it
+    /// @note gradient magnitude is quantized to 65536 levels
+    /// @complexity O(m*n)
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t&, const LabelImage& markers, Connectivity connectivity = Connectivity::FOUR);
+
+    /// @brief marker-controlled watershed, floods the gradient magnitude of the image starting at the markers
+    /// @param image: input image, the gradient is computed by crisp::compute_gradient_magnitude
+    /// @param markers: binary image, 8-connected marker pixels form one marker, markers are labeled 1, 2, ... in order of their first pixel left-to-right, top-to-bottom
+    /// @param connectivity: neighborhood of each pixel (default: 4-connected)
+    /// @returns label image, each pixel holds the label of the marker whose basin it belongs to or 0 if no marker reached it
+    /// @complexity O(m*n)
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t&, const BinaryImage& markers, Connectivity connectivity = Connectivity::FOUR);
+
+    /// @brief watershed without markers, floods the gradient magnitude of the image from each of its regional minima
+    /// @param image: input image, the gradient is computed by crisp::compute_gradient_magnitude
+    /// @param connectivity: neighborhood of each pixel (default: 4-connected)
+    /// @returns label image, each regional minimum is labeled 1, 2, ... in order of its first pixel left-to-right, top-to-bottom, each pixel holds the label of the minimum whose basin it belongs to
+    /// @note noise results in many shallow minima, smoothing the image first or supplying markers avoids over-segmentation
+    /// @complexity O(m*n)
+    template<typename Image_t>
+    LabelImage watershed_segmentation(const Image_t&, Connectivity connectivity = Connectivity::FOUR);
+
     /// @brief cluster image using k-means with specified number of clusters
     /// @param image: input image
     /// @param n_clusters
     /// @param max_n_iterations: number of iterations allowed if convergence is not achieved earlier
     /// @returns clustered image of same value type as input image
-    /// @note for crisp::ColorImage specifically a high-quality heuristic is applied to maximize color-distance between clusters
+    /// @note for crisp::ColorImage, initial centers are chosen by k-means++ and triangle-inequality bounds skip most distance computations
+    /// @note clustering operates on a quantized histogram of the image, each iteration is independent of the image size
+    /// @complexity O(n_pixels + n_iterations * n_clusters * n_distinct_colors) for color, O(n_pixels + n_iterations * n_clusters) for grayscale
     template<typename Image_t>
     Image_t k_means_clustering(const Image_t&, size_t n_clusters, size_t max_n_iterations = std::numeric_limits<size_t>::max());
+
+    /// @brief cluster color image using mini-batch k-means, each iteration moves the centers towards a random sample of pixels
+    /// @param image: input image
+    /// @param n_clusters
+    /// @param batch_size: number of pixels sampled per iteration
+    /// @param n_iterations: number of iterations, there is no convergence criterion
+    /// @returns clustered image, each pixel is assigned the value of its closest center
+    /// @note approximates crisp::Segmentation::k_means_clustering, results are reproducible as the random engine uses a fixed seed
+    /// @complexity O(n_pixels + n_iterations * batch_size * n_clusters)
+    ColorImage mini_batch_k_means_clustering(const ColorImage&, size_t n_clusters, size_t batch_size = 1024, size_t n_iterations = 100);
 }
 
 #include ".src/segmentation.inl"
\ No newline at end of file
@@ -0,0 +1,80 @@
+// 
+// Copyright 2026 Clemens Cords
+// Created on 19.10.26 by clem (mail@clemens-cords.com)
+//
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace crisp
+{
+    /// @brief process-wide pool of worker threads used to parallelize cpu-side algorithms
+    class ThreadPool
+    {
+        public:
+            /// @brief access the global pool, created on first use with one thread per hardware thread
+            /// @returns reference to pool
+            static ThreadPool& get();
+
+            /// @brief get number of threads participating in a parallel loop, including the calling thread
+            /// @returns number of threads
+            size_t get_n_threads() const;
+
+            /// @brief specify number of threads participating in a parallel loop, including the calling thread
+            /// @param n: number of threads, 1 disables multithreading
+            /// @note should not be called while a parallel loop is executing
+            void set_n_threads(size_t n);
+
+            /// @brief invoke a function once for each index in [0, n), distributed across all threads, blocks until all invocations returned
+            /// @param n: number of indices
+            /// @param function: callable with signature (size_t) -> void
+            /// @note indices are handed out in ascending order, the calling thread participates so this may be nested
+            template<typename Function_t>
+            void parallel_for(size_t n, Function_t&& function);
+
+            /// @brief split [0, n) into contiguous ranges and invoke a function for each range in parallel, blocks until all invocations returned
+            /// @param n: number of elements
+            /// @param function: callable with signature (size_t begin, size_t end) -> void
+            /// @param min_range_size: ranges will not be smaller than this, governs overhead for small n (default: 1)
+            template<typename Function_t>
+            void parallel_for_ranges(size_t n, Function_t&& function, size_t min_range_size = 1);
+
+            /// @brief split a 2d domain into rectangular tiles and invoke a function for each tile in parallel, blocks until all invocations returned
+            /// @param width: x-dimension of the domain
+            /// @param height: y-dimension of the domain
+            /// @param function: callable with signature (size_t x_begin, size_t x_end, size_t y_begin, size_t y_end) -> void
+            /// @param tile_width: x-dimension of each tile, tiles at the domains border may be smaller
+            /// @param tile_height: y-dimension of each tile, tiles at the domains border may be smaller
+            /// @note tiles are enumerated x-first so tiles covering the same columns of a column-major image are handed out consecutively
+            template<typename Function_t>
+            void parallel_for_tiles(size_t width, size_t height, Function_t&& function, size_t tile_width, size_t tile_height);
+
+            /// @brief dtor, joins all worker threads
+            ~ThreadPool();
+
+        private:
+            ThreadPool(size_t n_workers);
+
+            void start(size_t n_workers);
+            void stop();
+
+            void submit(std::function<void()>);
+            void worker_loop();
+
+            std::vector<std::thread> _workers;
+
+            std::deque<std::function<void()>> _queue;
+            std::mutex _queue_mutex;
+            std::condition_variable _queue_cv;
+            bool _shutdown = false;
+    };
+}
+
+#include ".src/thread_pool.inl"